@@ -0,0 +1,494 @@
+#include "pch.h"
+#include "AstCache.h"
+#include "CodeGenerator.h"
+#include "CorpusGenerator.h"
+#include "Incremental.h"
+#include "NodeVisitor.h"
+#include "PeakMemory.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct BenchmarkResult
+{
+	string Name;
+	int Lines = 0;
+	size_t Bytes = 0;
+	size_t Tokens = 0;
+	size_t Nodes = 0;
+	int Errors = 0;
+	double LexSeconds = 0;
+	double ParseSeconds = 0;
+	double ResolveSeconds = 0;
+	double CodegenSeconds = 0;
+	const char* Cache = "off";
+	double CacheLoadSeconds = 0;
+};
+
+//with --ast-cache every case is also looked up in the cache, a miss saves its tree
+AstCache* cache = nullptr;
+int cacheLookups = 0;
+int cacheHits = 0;
+
+//with --edits every case is also edited at random through IncrementalSource,
+//the tree and errors after each edit have to be the same as those of a full parse
+int editsCount = 0;
+int editMismatches = 0;
+
+//texts inserted by random edits, most of them break the source somewhere
+const char* EditTexts[] = { "", "\n", "{", "}", "(", ")", ";", ",", "\"", "'", "/*", "*/", "@", "+ 1", "int x = 1;\n",
+	"if (x < 2) {\n", "void f() {}\n", "string s = \"a\";\n" };
+const int EditTextsCount = sizeof(EditTexts) / sizeof(EditTexts[0]);
+
+double seconds_since(Clock::time_point start)
+{
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+double per_second(size_t count, double seconds)
+{
+	return seconds > 0 ? count / seconds : 0;
+}
+
+//every phase is timed on its own, lexems are lexed before parsing like for big sources
+BenchmarkResult run_case(const string& name, const SourceBuffer& source)
+{
+	BenchmarkResult result;
+	result.Name = name;
+	result.Lines = (int)count(source.Text.begin(), source.Text.end(), '\n');
+	result.Bytes = source.Text.size();
+	fileName = name;
+	ErrorHandler::clear();
+
+	Clock::time_point start = Clock::now();
+	LexemStore lexemStore;
+	lex_all(source, lexemStore);
+	result.LexSeconds = seconds_since(start);
+	result.Tokens = lexemStore.size();
+
+	//rewound nodes are counted too
+	start = Clock::now();
+	Parser parser;
+	SyntaxTree_Ptr tree = parser.build_syntax_tree(lexemStore);
+	result.ParseSeconds = seconds_since(start);
+	result.Nodes = tree->NodesCount();
+
+	if (cache != nullptr)
+	{
+		start = Clock::now();
+		SyntaxTree_Ptr cached = cache->Load(source.Text);
+		result.CacheLoadSeconds = seconds_since(start);
+		cacheLookups++;
+		if (cached != nullptr)
+		{
+			cacheHits++;
+			result.Cache = "hit";
+		}
+		else
+		{
+			result.Cache = "miss";
+			if (errorsCount == 0)
+				cache->Save(source.Text, *tree);
+		}
+	}
+
+	start = Clock::now();
+	Scope_Ptr programScope = make_shared<Scope>();
+	tree->resolveNames(programScope);
+	result.ResolveSeconds = seconds_since(start);
+	ErrorHandler::printErrors();
+
+	result.Errors = errorsCount;
+	if (errorsCount > 0)
+		return result;
+
+	start = Clock::now();
+	ProgramCode_Ptr code = make_shared<ProgramCode>();
+	try {
+		tree->generateCode(code);
+	}
+	catch (exception)
+	{
+
+	}
+	result.CodegenSeconds = seconds_since(start);
+	return result;
+}
+
+//kinds, lines, names, values and flags of all nodes in source order, lines are counted from the start of source.
+//Texts has the values which are not integers.
+struct TreeShape
+{
+	vector<int> Values;
+	vector<string> Texts;
+	int LineBase = 0;
+
+	bool operator!=(const TreeShape& other) const
+	{
+		return Values != other.Values || Texts != other.Texts;
+	}
+
+	void line(int line)
+	{
+		Values.push_back(line == 0 ? 0 : line + LineBase);
+	}
+	void node(Node* node)
+	{
+		Values.push_back(node->Kind);
+		line(node->LineNumber);
+	}
+
+	void visit(Node* node)
+	{
+		this->node(node);
+	}
+	void visit(Identifier* identifier)
+	{
+		node(identifier);
+		Values.push_back(identifier->Value);
+	}
+	void visit(TypeKeyword* keyword)
+	{
+		node(keyword);
+		Values.push_back(keyword->IsPointer);
+	}
+	void visit(Function* function)
+	{
+		node(function);
+		Values.push_back(function->HasReturn);
+	}
+	void visit(ParamDef* param)
+	{
+		node(param);
+		Values.push_back(param->HasSeperator);
+	}
+	void visit(FunctionParamsDef* params)
+	{
+		node(params);
+		Values.push_back(params->HasListEnd);
+	}
+	void visit(BlockBody* block)
+	{
+		node(block);
+		Values.push_back(block->HasEnd);
+	}
+	void visit(EmptyStatement* statement)
+	{
+		node(statement);
+		Values.push_back(statement->HasEndToken);
+	}
+	void visit(BinaryExpression* expression)
+	{
+		node(expression);
+		line(expression->OperatorLine);
+		Values.push_back(expression->Operator);
+	}
+	void visit(IdentifierExpression* expression)
+	{
+		node(expression);
+		Values.push_back(expression->Value);
+	}
+	void visit(FunctionParams* params)
+	{
+		node(params);
+		Values.push_back(params->HasListEnd);
+	}
+	void visit(Param* param)
+	{
+		node(param);
+		Values.push_back(param->HasSeperator);
+	}
+	void visit(StringExpression* expression)
+	{
+		node(expression);
+		Texts.push_back(expression->Value);
+	}
+	void visit(CharExpression* expression)
+	{
+		node(expression);
+		Values.push_back(expression->Value);
+	}
+	void visit(IntegerExpression* expression)
+	{
+		node(expression);
+		Values.push_back(expression->Value);
+	}
+	void visit(FloatExpression* expression)
+	{
+		node(expression);
+		char text[64];
+		snprintf(text, sizeof(text), "%a", expression->Value);
+		Texts.push_back(text);
+	}
+};
+
+TreeShape tree_shape(const SyntaxTree& tree)
+{
+	TreeShape shape;
+	for (Function* function : tree.functions)
+	{
+		shape.LineBase = function->LineBase;
+		walk_tree(function, shape);
+	}
+	return shape;
+}
+
+bool same_errors(const vector<Diagnostic>& left, const vector<Diagnostic>& right)
+{
+	if (left.size() != right.size())
+		return false;
+	for (size_t i = 0; i < left.size(); i++)
+	{
+		if (left[i].Line != right[i].Line || left[i].Column != right[i].Column || left[i].Count != right[i].Count
+			|| ErrorHandler::message(left[i]) != ErrorHandler::message(right[i]))
+			return false;
+	}
+	return true;
+}
+
+//statement added to a function body and removed again by local edits
+const char* LocalEditText = "\tint x = 1;\n";
+
+//parses all of the edited source, mismatches are counted when the tree or errors of the edit differ from it
+struct EditChecker
+{
+	double ParseSeconds = 0;
+	int Mismatches = 0;
+
+	void check(IncrementalSource& incremental, const SyntaxTree& tree)
+	{
+		vector<Diagnostic> errors = ErrorHandler::recorded();
+		ErrorHandler::clear();
+		SourceBuffer edited;
+		edited.Text = incremental.Source.Text;
+		Clock::time_point start = Clock::now();
+		LexemStore lexemStore;
+		lex_all(edited, lexemStore);
+		Parser parser;
+		SyntaxTree_Ptr parsed = parser.build_syntax_tree(lexemStore);
+		ParseSeconds += seconds_since(start);
+
+		if (tree_shape(tree) != tree_shape(*parsed) || !same_errors(errors, ErrorHandler::recorded()))
+			Mismatches++;
+		ErrorHandler::clear();
+	}
+};
+
+//edits the source at random offsets, timing Edit and Tree against lexing and parsing all of it.
+//Local edits come first, they add a statement line after a statement of a random function and remove it,
+//as typing in one function does. Their time should stay the same whatever the size of the source.
+void run_edits(const string& name, const SourceBuffer& source, unsigned seed)
+{
+	fileName = name;
+	IncrementalSource incremental;
+	incremental.Reset(source.Text);
+	//64 bits, so offsets reach the end of big sources
+	unsigned long long randomState = seed;
+	auto random = [&randomState](int limit)
+	{
+		randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (int)((randomState >> 33) % (unsigned)limit);
+	};
+	EditChecker checker;
+
+	double localSeconds = 0;
+	int localEdits = 0;
+	for (int i = 0; i < editsCount; i++)
+	{
+		const string& text = incremental.Source.Text;
+		size_t offset = text.find(";\n", (size_t)random((int)text.size()));
+		if (offset == string::npos)
+			continue;
+		offset += 2;
+
+		for (int j = 0; j < 2; j++)
+		{
+			ErrorHandler::clear();
+			Clock::time_point start = Clock::now();
+			if (j == 0)
+				incremental.Edit(offset, 0, LocalEditText);
+			else
+				incremental.Edit(offset, strlen(LocalEditText), "");
+			SyntaxTree_Ptr tree = incremental.Tree();
+			localSeconds += seconds_since(start);
+			localEdits++;
+			checker.check(incremental, *tree);
+		}
+	}
+
+	double editSeconds = 0;
+	int reused = 0;
+	for (int i = 0; i < editsCount; i++)
+	{
+		size_t offset = (size_t)random((int)incremental.Source.Text.size() + 1);
+		size_t removedLength = (size_t)random(16);
+		string insertedText = EditTexts[random(EditTextsCount)];
+
+		ErrorHandler::clear();
+		Clock::time_point start = Clock::now();
+		if (incremental.Edit(offset, removedLength, insertedText))
+			reused++;
+		SyntaxTree_Ptr tree = incremental.Tree();
+		editSeconds += seconds_since(start);
+		checker.check(incremental, *tree);
+	}
+	editMismatches += checker.Mismatches;
+
+	int checks = localEdits + editsCount;
+	printf("{\"case\":\"%s\",\"lines\":%d,\"edits\":%d,\"incremental_edits\":%d,\"mismatches\":%d,"
+		"\"local_edit_ms\":%.3f,\"edit_ms\":%.3f,\"reparse_ms\":%.3f}\n",
+		name.c_str(), (int)count(source.Text.begin(), source.Text.end(), '\n'), editsCount, reused, checker.Mismatches,
+		localEdits > 0 ? localSeconds * 1000 / localEdits : 0, editSeconds * 1000 / editsCount, checker.ParseSeconds * 1000 / checks);
+	fflush(stdout);
+}
+
+//one json object per line
+void print_result(const BenchmarkResult& result)
+{
+	printf("{\"case\":\"%s\",\"lines\":%d,\"bytes\":%zu,\"tokens\":%zu,\"nodes\":%zu,\"errors\":%d,"
+		"\"lex_ms\":%.3f,\"parse_ms\":%.3f,\"resolve_ms\":%.3f,\"codegen_ms\":%.3f,"
+		"\"cache\":\"%s\",\"cache_load_ms\":%.3f,\"tokens_per_sec\":%.0f,\"nodes_per_sec\":%.0f,\"peak_rss_kb\":%zu}\n",
+		result.Name.c_str(), result.Lines, result.Bytes, result.Tokens, result.Nodes, result.Errors,
+		result.LexSeconds * 1000, result.ParseSeconds * 1000, result.ResolveSeconds * 1000, result.CodegenSeconds * 1000,
+		result.Cache, result.CacheLoadSeconds * 1000, per_second(result.Tokens, result.LexSeconds), per_second(result.Nodes, result.ParseSeconds), peak_rss_kb());
+	fflush(stdout);
+}
+
+int find_shape(const string& name)
+{
+	for (int i = 0; i < CorpusShapesCount; i++)
+	{
+		if (name == CorpusShapeNames[i])
+			return i;
+	}
+	return -1;
+}
+
+void print_usage()
+{
+	printf("Benchmark [--shape mixed|nesting|wide|expressions|strings|deep|all] [--lines N[,N...]] [--depth N] [--width N]\n"
+		"          [--terms N] [--seed N] [--baseline file] [--emit file] [--ast-cache directory] [--edits N]\n"
+		"Without --lines every shape is run with 1000 and 10000 lines, other sizes up to 1000000 are given by --lines.\n"
+		"Peak RSS is the peak of the whole process, run one case at a time to compare it.\n"
+		"--emit writes the generated program of the first case and exits.\n"
+		"--ast-cache loads every case from the cache after it was parsed, run twice to time the hits.\n"
+		"--edits applies N local and N random edits to every case incrementally and checks each against a full parse,\n"
+		"        the exit code is 1 if any of them differs. local_edit_ms should not grow with --lines, for example\n"
+		"        with --shape mixed --lines 1000,8000,64000 --edits 200.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	CorpusOptions options;
+	vector<int> shapes;
+	vector<int> sizes = { 1000, 10000 };
+	string baseline = "gyvatele";
+	string emitFile;
+	string cacheDirectory;
+	for (int i = 1; i < argc; i++)
+	{
+		string argument = argv[i];
+		if (i + 1 >= argc)
+		{
+			print_usage();
+			return -1;
+		}
+		string value = argv[++i];
+		if (argument == "--shape")
+		{
+			int shape = find_shape(value);
+			if (shape < 0 && value != "all")
+			{
+				print_usage();
+				return -1;
+			}
+			if (shape >= 0)
+				shapes.push_back(shape);
+		}
+		else if (argument == "--lines")
+		{
+			sizes.clear();
+			size_t start = 0;
+			size_t comma;
+			while ((comma = value.find(',', start)) != string::npos)
+			{
+				sizes.push_back(atoi(value.c_str() + start));
+				start = comma + 1;
+			}
+			sizes.push_back(atoi(value.c_str() + start));
+		}
+		else if (argument == "--depth")
+			options.Depth = atoi(value.c_str());
+		else if (argument == "--width")
+			options.Width = atoi(value.c_str());
+		else if (argument == "--terms")
+			options.Terms = atoi(value.c_str());
+		else if (argument == "--seed")
+			options.Seed = (unsigned)atoi(value.c_str());
+		else if (argument == "--baseline")
+			baseline = value;
+		else if (argument == "--emit")
+			emitFile = value;
+		else if (argument == "--ast-cache")
+			cacheDirectory = value;
+		else if (argument == "--edits")
+			editsCount = atoi(value.c_str());
+		else
+		{
+			print_usage();
+			return -1;
+		}
+	}
+	if (shapes.empty())
+	{
+		for (int i = 0; i < CorpusShapesCount; i++)
+			shapes.push_back(i);
+	}
+
+	if (!emitFile.empty())
+	{
+		options.Shape = (CorpusShape)shapes[0];
+		options.Lines = sizes[0];
+		ofstream file(emitFile.c_str(), ios::binary);
+		file << CorpusGenerator(options).Generate();
+		return file ? 0 : -1;
+	}
+
+	AstCache astCache(cacheDirectory);
+	if (!cacheDirectory.empty())
+		cache = &astCache;
+
+	//fixed baseline, it does not change when the generator does
+	SourceBuffer source;
+	if (!baseline.empty())
+	{
+		if (source.Load(baseline) && !source.Text.empty())
+		{
+			print_result(run_case("gyvatele", source));
+			if (editsCount > 0)
+				run_edits("gyvatele", source, options.Seed);
+		}
+		else
+			fprintf(stderr, "baseline %s was not found\n", baseline.c_str());
+	}
+
+	for (int shape : shapes)
+	{
+		for (int lines : sizes)
+		{
+			options.Shape = (CorpusShape)shape;
+			options.Lines = lines;
+			source.Text = CorpusGenerator(options).Generate();
+			print_result(run_case(CorpusShapeNames[shape], source));
+			if (editsCount > 0)
+				run_edits(CorpusShapeNames[shape], source, options.Seed);
+		}
+	}
+	if (cache != nullptr)
+		printf("{\"cache_lookups\":%d,\"cache_hits\":%d}\n", cacheLookups, cacheHits);
+	return editMismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "CorpusGenerator.h"
+
+using namespace std;
+
+const char* CorpusShapeNames[CorpusShapesCount] = { "mixed", "nesting", "wide", "expressions", "strings", "deep" };
+
+//variables every generated function declares first, so statements can use them at any depth
+const int FunctionVariables = 4;
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+{
+	this->options = options;
+	randomState = options.Seed;
+}
+
+string CorpusGenerator::Generate()
+{
+	text.clear();
+	lines = 0;
+	functionsCount = 0;
+	while (lines < options.Lines)
+	{
+		switch (options.Shape)
+		{
+		case DeepNesting:
+			nested_function();
+			break;
+		case WideFunctions:
+			wide_function();
+			break;
+		case LongExpressions:
+			expressions_function();
+			break;
+		case ManyStrings:
+			strings_function();
+			break;
+		case DeepExpressions:
+			deep_function();
+			break;
+		default:
+			mixed_function();
+			break;
+		}
+	}
+
+	open_block("void main()");
+	for (int i = 0; i < functionsCount && i < 16; i++)
+		line("int r" + to_string(i) + " = f" + to_string(i) + "(" + to_string(i) + ", 2, 'm', \"main\");");
+	close_block();
+	return text;
+}
+
+int CorpusGenerator::random(int limit)
+{
+	randomState = randomState * 1103515245 + 12345;
+	return (int)((randomState >> 16) % (unsigned)limit);
+}
+
+void CorpusGenerator::line(const string& code)
+{
+	text.append(indent, '\t');
+	text += code;
+	text += '\n';
+	lines++;
+}
+
+void CorpusGenerator::open_block(const string& header)
+{
+	line(header);
+	line("{");
+	indent++;
+}
+
+void CorpusGenerator::close_block()
+{
+	indent--;
+	line("}");
+}
+
+string CorpusGenerator::variable(int index)
+{
+	return "v" + to_string(index);
+}
+
+string CorpusGenerator::int_expression(int terms)
+{
+	static const char* operators[] = { " + ", " - ", " * " };
+	string expression;
+	for (int i = 0; i < terms; i++)
+	{
+		if (i > 0)
+			expression += operators[random(3)];
+
+		int operand = random(10);
+		if (operand < 4)
+			expression += variable(operand);
+		else if (operand < 6)
+			expression += operand == 4 ? "a" : "b";
+		else if (operand < 8 || terms - i < 3)
+			expression += to_string(random(1000));
+		else
+		{
+			int grouped = 2 + random(2);
+			expression += "(" + int_expression(grouped) + ")";
+			i += grouped - 1;
+		}
+	}
+	return expression;
+}
+
+string CorpusGenerator::string_literal()
+{
+	static const char* words[] = { "snake", "score", "level", "game", "over", "speed", "map", "head", "tail", "treat" };
+	//backslash itself is not escaped by the lexer
+	static const char* escapes[] = { "\\n", "\\t", "\\\"" };
+	string literal = "\"";
+	int count = 1 + random(6);
+	for (int i = 0; i < count; i++)
+	{
+		if (i > 0)
+			literal += ' ';
+		literal += words[random(10)];
+		if (random(4) == 0)
+			literal += escapes[random(3)];
+	}
+	return literal + "\"";
+}
+
+void CorpusGenerator::function_header()
+{
+	open_block("int f" + to_string(functionsCount) + "(int a, int b, char c, string s)");
+	for (int i = 0; i < FunctionVariables; i++)
+		line("int " + variable(i) + " = a + " + to_string(i) + ";");
+}
+
+void CorpusGenerator::function_footer()
+{
+	line("return " + variable(0) + " + " + variable(1) + ";");
+	close_block();
+	line("");
+	functionsCount++;
+}
+
+void CorpusGenerator::statement()
+{
+	string target = variable(random(FunctionVariables));
+	switch (random(8))
+	{
+	case 0:
+	case 1:
+		line(target + " = " + int_expression(2 + random(6)) + ";");
+		break;
+	case 2:
+		line("int w" + to_string(variablesCount++) + " = " + int_expression(1 + random(4)) + ";");
+		break;
+	case 3:
+		line("char k" + to_string(variablesCount++) + " = '" + (char)('a' + random(26)) + "';");
+		break;
+	case 4:
+		if (functionsCount > 0)
+		{
+			line(target + " = f" + to_string(random(functionsCount)) + "(" + variable(random(FunctionVariables)) + ", " + to_string(random(100)) + ", c, s);");
+			break;
+		}
+		line(target + " = " + target + " + 1;");
+		break;
+	case 5:
+		line("print << c;");
+		break;
+	case 6:
+		line("string t" + to_string(variablesCount++) + " = " + string_literal() + ";");
+		break;
+	default:
+		line("bool ok" + to_string(variablesCount++) + " = " + target + " < " + to_string(random(100)) + " or c == 'x';");
+		break;
+	}
+}
+
+void CorpusGenerator::mixed_function()
+{
+	function_header();
+	int statements = 10 + random(30);
+	for (int i = 0; i < statements; i++)
+	{
+		int kind = random(10);
+		string counter = variable(random(FunctionVariables));
+		if (kind == 0)
+		{
+			open_block("while " + counter + " < " + to_string(10 + random(90)));
+			statement();
+			statement();
+			line(counter + " = " + counter + " + 1;");
+			close_block();
+		}
+		else if (kind == 1)
+		{
+			open_block("if " + counter + " > " + to_string(random(50)) + " and c <> 'q'");
+			statement();
+			close_block();
+			open_block("else if " + counter + " == " + to_string(random(50)));
+			statement();
+			close_block();
+			open_block("else");
+			statement();
+			close_block();
+		}
+		else
+			statement();
+	}
+	function_footer();
+}
+
+void CorpusGenerator::nested_function()
+{
+	function_header();
+	for (int repeat = 0; repeat < 2; repeat++)
+	{
+		for (int depth = 0; depth < options.Depth; depth++)
+		{
+			string counter = variable(depth % FunctionVariables);
+			if (depth % 2 == 0)
+				open_block("while " + counter + " < " + to_string(100 + depth));
+			else
+				open_block("if " + counter + " > " + to_string(depth));
+			statement();
+		}
+		for (int depth = 0; depth < options.Depth; depth++)
+		{
+			line(variable(depth % FunctionVariables) + " = " + variable(depth % FunctionVariables) + " + 1;");
+			close_block();
+		}
+	}
+	function_footer();
+}
+
+void CorpusGenerator::wide_function()
+{
+	function_header();
+	for (int i = 0; i < options.Width; i++)
+		statement();
+	function_footer();
+}
+
+void CorpusGenerator::expressions_function()
+{
+	function_header();
+	for (int i = 0; i < 20; i++)
+	{
+		if (i % 5 == 4)
+		{
+			open_block("if " + int_expression(options.Terms / 2) + " > " + int_expression(options.Terms / 2) + " or c == 'e'");
+			line(variable(0) + " = " + variable(0) + " + 1;");
+			close_block();
+		}
+		else
+			line(variable(i % FunctionVariables) + " = " + int_expression(options.Terms) + ";");
+	}
+	function_footer();
+}
+
+void CorpusGenerator::strings_function()
+{
+	function_header();
+	for (int i = 0; i < 30; i++)
+	{
+		if (functionsCount > 0 && i % 3 == 0)
+			line(variable(i % FunctionVariables) + " = f" + to_string(random(functionsCount)) + "(a, b, 's', " + string_literal() + ");");
+		else
+			line("string t" + to_string(variablesCount++) + " = " + string_literal() + ";");
+	}
+	function_footer();
+}
+
+//expressions as deep as the operands, groups, unary operators and calls in them
+void CorpusGenerator::deep_function()
+{
+	function_header();
+	string chain = variable(0);
+	for (int i = 1; i < options.Terms; i++)
+		chain += (i % 2 == 0 ? " + " : " * ") + to_string(random(10));
+	line(variable(1) + " = " + chain + ";");
+
+	string groups(options.Depth, '(');
+	groups += variable(1);
+	for (int i = 0; i < options.Depth; i++)
+		groups += ") + " + to_string(i % 10);
+	line(variable(2) + " = " + groups + ";");
+
+	line(variable(3) + " = " + string(options.Depth, '-') + variable(2) + ";");
+
+	string nots;
+	for (int i = 0; i < options.Depth; i++)
+		nots += "not ";
+	line("bool ok" + to_string(variablesCount++) + " = " + nots + "(" + variable(3) + " < 10);");
+
+	if (functionsCount > 0)
+	{
+		string function = "f" + to_string(random(functionsCount));
+		string calls;
+		for (int i = 0; i < options.Depth; i++)
+			calls += function + "(";
+		calls += variable(0);
+		for (int i = 0; i < options.Depth; i++)
+			calls += ", " + to_string(i % 10) + ", c, s)";
+		line(variable(0) + " = " + calls + ";");
+	}
+	function_footer();
+}
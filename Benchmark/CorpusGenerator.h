@@ -0,0 +1,60 @@
+#pragma once
+
+#include "pch.h"
+
+enum CorpusShape
+{
+	MixedCorpus,
+	DeepNesting,
+	WideFunctions,
+	LongExpressions,
+	ManyStrings,
+	DeepExpressions,
+	CorpusShapesCount
+};
+
+extern const char* CorpusShapeNames[CorpusShapesCount];
+
+struct CorpusOptions
+{
+	CorpusShape Shape = MixedCorpus;
+	int Lines = 1000;
+	int Depth = 48;		//nesting of DeepNesting blocks and DeepExpressions expressions
+	int Width = 4000;	//statements in one WideFunctions function
+	int Terms = 64;		//operands in one LongExpressions expression and DeepExpressions chain
+	unsigned Seed = 1;
+};
+
+//generates a valid program of about Lines lines, functions only call each other and builtins are not used
+struct CorpusGenerator
+{
+	CorpusGenerator(const CorpusOptions& options);
+	std::string Generate();
+
+private:
+	CorpusOptions options;
+	std::string text;
+	int lines = 0;
+	int indent = 0;
+	int functionsCount = 0;
+	int variablesCount = 0;
+	unsigned randomState;
+
+	int random(int limit);
+	void line(const std::string& code);
+	void open_block(const std::string& header);
+	void close_block();
+	std::string variable(int index);
+	std::string int_expression(int terms);
+	std::string string_literal();
+
+	void function_header();
+	void function_footer();
+	void mixed_function();
+	void nested_function();
+	void wide_function();
+	void expressions_function();
+	void strings_function();
+	void deep_function();
+	void statement();
+};
@@ -0,0 +1,29 @@
+#include "pch.h"
+#include "PeakMemory.h"
+
+//platform headers are kept away from compiler headers, their macros clash with compiler names
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+size_t peak_rss_kb()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize / 1024;
+}
+#else
+#include <sys/resource.h>
+
+size_t peak_rss_kb()
+{
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return (size_t)usage.ru_maxrss;
+}
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "pch.h"
+
+//peak resident set size of the whole process in kilobytes
+size_t peak_rss_kb();
@@ -1,13 +1,267 @@
 #include "pch.h"
 #include "ErrorHandler.h"
+#include <mutex>
 
 int errorsCount = 0;
 std::string fileName = "";
-void ErrorHandler::printError(int lineNumber, const char* errorMessage, int lineOffset)
+thread_local ErrorBuffer* threadBuffer = nullptr;
+thread_local int threadLineBase = 0;
+
+const char* ErrorTexts[] = {
+	"Unexpected char",
+	"Unknown escaped symbol found \\%c",
+	"Unterminated string",
+	"Empty char not allowed",
+	"Unterminated char",
+	"Expected comment start, but found %c",
+	"Unterminated comment",
+	"Unexpected constant prefix %c",
+	"expected matching closing bracket",
+	"Expected matching closing bracket",
+	"Unexpected extra , token",
+	"missing type specifier",
+	"missing parameter identifier",
+	"Unexpected seperator token",
+	"Expected separator token",
+	"Expected ), but found something else",
+	"Unterminated statement. Expected ;",
+	"Expected expression",
+	"Unmatched paranthesis",
+	"Missing right side",
+	"Missing left side",
+	"Incorect right side expression",
+	"Expected variable declaration identifier",
+	"expected array size",
+	"Missing variable identifier",
+	"Missing expression",
+	"Expected bool expression",
+	"Expected body",
+	"expected else body",
+	"Unmatched Block start",
+	"Unexpected identifier",
+	"Expected function declaration",
+	"Expected function declaration, but found some trash",
+	"Missing function return type",
+	"Missing function name",
+	"Missing parameters",
+	"Missing function body",
+	"Both sides of operator should have the same type. Left side is: %s Right side is: %s",
+	"Cannot perform operation with %s type",
+	"Function %s cannot be used as variable",
+	"Variable %s is already defined in this scope",
+	"Variable %s is not defined in this scope",
+	"Main function does not exist",
+	"Main function should be void type function",
+	"Main function should be function without parameters",
+	"Function missing return statement",
+	"cannot modify string type variable",
+	"Cannot assign %s type expression to %s type variable",
+	"void type function cannot return value",
+	"function should return value",
+	"Cannot return %s type expression in function with return type %s",
+	"Return statement should be inside function.",
+	"Condition should be boolean type",
+	"Break statement should be inside a cycle",
+	"Cannot access member for non array type variable",
+	"array index should Integer type expression",
+	"Variable %s used as function",
+	"missmatched parameters count",
+	"Cannot use %s type expression as %s type parameter",
+	"Cannot apply operator for not numeric type: %s",
+	"Cannot apply operator for not boolean type: %s"
+};
+static_assert(sizeof(ErrorTexts) / sizeof(ErrorTexts[0]) == ErrorCodesCount, "Every error code needs an entry in ErrorTexts");
+
+const size_t ReservedErrors = 1024;
+
+//errors reported without a buffer, they are guarded by reportedLock together with errorsCount
+static std::vector<Diagnostic> reported;
+static size_t printedCount = 0;
+static std::mutex reportedLock;
+static int maxErrors = 0;
+
+static bool same_argument(const char* left, const char* right)
+{
+	if (left == right)
+		return true;
+	return left != nullptr && right != nullptr && strcmp(left, right) == 0;
+}
+
+static bool same_error(const Diagnostic& left, const Diagnostic& right)
 {
+	return left.Code == right.Code && left.Line == right.Line && left.Column == right.Column && left.Symbol == right.Symbol
+		&& same_argument(left.Arguments[0], right.Arguments[0]) && same_argument(left.Arguments[1], right.Arguments[1]);
+}
+
+//false when the error is a cascade or over the limit
+static bool record(std::vector<Diagnostic>& errors, int& count, int limit, const Diagnostic& error)
+{
+	if (!errors.empty() && same_error(errors.back(), error))
+		return false;
+	if (limit > 0 && count >= limit)
+		return false;
+
+	if (errors.capacity() == 0)
+		errors.reserve(ReservedErrors);
+	errors.push_back(error);
+	count += error.Count;
+	return true;
+}
+
+static bool report(const Diagnostic& error)
+{
+	//a buffer keeps one error over the limit, the first error of it can be a cascade of errors flushed before
+	if (threadBuffer != nullptr)
+		return record(threadBuffer->Errors, threadBuffer->Count, maxErrors > 0 ? maxErrors + 1 : 0, error);
+
+	std::lock_guard<std::mutex> guard(reportedLock);
+	return record(reported, errorsCount, maxErrors, error);
+}
+
+//0 is kept for errors without a line
+static int absolute_line(int line, int lineBase)
+{
+	return line == 0 ? 0 : line + lineBase;
+}
+
+void ErrorHandler::printError(int lineNumber, ErrorCode code, const char* argument, const char* secondArgument)
+{
+	report({ code, absolute_line(lineNumber, threadLineBase), 0, { argument, secondArgument }, 0, 1 });
+}
+
+bool ErrorHandler::printLexError(int lineNumber, int lineOffset, ErrorCode code, char symbol)
+{
+	return report({ code, absolute_line(lineNumber, threadLineBase), lineOffset, { nullptr, nullptr }, symbol, 1 });
+}
+
+void ErrorHandler::countError()
+{
+	if (threadBuffer != nullptr)
+	{
+		if (!threadBuffer->Errors.empty())
+			threadBuffer->Errors.back().Count++;
+		threadBuffer->Count++;
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(reportedLock);
+	if (!reported.empty())
+		reported.back().Count++;
 	errorsCount++;
-	if (lineOffset != 0)
-		fprintf(stderr, "%s:%d:%d error: %s\n", fileName.c_str(), lineNumber, lineOffset, errorMessage);
-	else
-		fprintf(stderr, "%s:%d: error: %s\n", fileName.c_str(), lineNumber, errorMessage);
-}
\ No newline at end of file
+}
+
+void ErrorHandler::setMaxErrors(int _maxErrors)
+{
+	maxErrors = _maxErrors;
+}
+
+bool ErrorHandler::limitReached()
+{
+	if (maxErrors == 0)
+		return false;
+	if (threadBuffer != nullptr)
+		return threadBuffer->Count > maxErrors;
+
+	std::lock_guard<std::mutex> guard(reportedLock);
+	return errorsCount >= maxErrors;
+}
+
+void ErrorHandler::setBuffer(ErrorBuffer* buffer)
+{
+	threadBuffer = buffer;
+}
+
+void ErrorHandler::setLineBase(int base)
+{
+	threadLineBase = base;
+}
+
+void ErrorHandler::flush(const ErrorBuffer& buffer, size_t begin, size_t end)
+{
+	if (end > buffer.Errors.size())
+		end = buffer.Errors.size();
+
+	std::lock_guard<std::mutex> guard(reportedLock);
+	for (size_t i = begin; i < end; i++)
+		record(reported, errorsCount, maxErrors, buffer.Errors[i]);
+}
+
+void ErrorHandler::flush(const std::vector<Diagnostic>& errors, int lineBase)
+{
+	std::lock_guard<std::mutex> guard(reportedLock);
+	for (Diagnostic error : errors)
+	{
+		error.Line = absolute_line(error.Line, lineBase);
+		record(reported, errorsCount, maxErrors, error);
+	}
+}
+
+static void append_message(std::string& text, const Diagnostic& error)
+{
+	int argument = 0;
+	for (const char* c = ErrorTexts[error.Code]; *c != '\0'; c++)
+	{
+		if (c[0] == '%' && c[1] == 's')
+		{
+			const char* value = argument < 2 ? error.Arguments[argument++] : nullptr;
+			if (value != nullptr)
+				text += value;
+			c++;
+		}
+		else if (c[0] == '%' && c[1] == 'c')
+		{
+			//message ends at a zero symbol, as it did when the symbol was appended to it
+			if (error.Symbol != '\0')
+				text += error.Symbol;
+			c++;
+		}
+		else
+			text += *c;
+	}
+}
+
+std::string ErrorHandler::message(const Diagnostic& error)
+{
+	std::string text;
+	append_message(text, error);
+	return text;
+}
+
+void ErrorHandler::printErrors()
+{
+	std::lock_guard<std::mutex> guard(reportedLock);
+	std::string text;
+	char prefix[64];
+	for (size_t i = printedCount; i < reported.size(); i++)
+	{
+		const Diagnostic& error = reported[i];
+		if (error.Column != 0)
+			snprintf(prefix, sizeof(prefix), ":%d:%d error: ", error.Line, error.Column);
+		else
+			snprintf(prefix, sizeof(prefix), ":%d: error: ", error.Line);
+		text += fileName;
+		text += prefix;
+		append_message(text, error);
+		text += '\n';
+	}
+	if (maxErrors > 0 && errorsCount >= maxErrors && printedCount < reported.size())
+		text += "compilation terminated due to --max-errors=" + std::to_string(maxErrors) + ".\n";
+
+	fwrite(text.data(), 1, text.size(), stderr);
+	fflush(stderr);
+	printedCount = reported.size();
+}
+
+std::vector<Diagnostic> ErrorHandler::recorded()
+{
+	std::lock_guard<std::mutex> guard(reportedLock);
+	return reported;
+}
+
+void ErrorHandler::clear()
+{
+	std::lock_guard<std::mutex> guard(reportedLock);
+	reported.clear();
+	printedCount = 0;
+	errorsCount = 0;
+}
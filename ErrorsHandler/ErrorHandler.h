@@ -3,10 +3,126 @@
 #include <stdio.h>
 #include <string.h>
 
+//every error the compiler reports, its text is in ErrorTexts.
+//%s in a text is replaced by the next argument of the error, %c by its symbol.
+enum ErrorCode
+{
+	//lexer
+	Error_UnexpectedChar,
+	Error_UnknownEscape,
+	Error_UnterminatedString,
+	Error_EmptyChar,
+	Error_UnterminatedChar,
+	Error_ExpectedCommentStart,
+	Error_UnterminatedComment,
+	Error_UnexpectedConstantPrefix,
+	//parser
+	Error_ExpectedClosingBracket,
+	Error_ExpectedParameterClosingBracket,
+	Error_ExtraSeparator,
+	Error_MissingTypeSpecifier,
+	Error_MissingParameterIdentifier,
+	Error_UnexpectedSeparator,
+	Error_ExpectedSeparator,
+	Error_ExpectedClosingParanthesis,
+	Error_UnterminatedStatement,
+	Error_ExpectedExpression,
+	Error_UnmatchedParanthesis,
+	Error_MissingRightSide,
+	Error_MissingLeftSide,
+	Error_IncorectRightSide,
+	Error_ExpectedDeclarationIdentifier,
+	Error_ExpectedArraySize,
+	Error_MissingVariableIdentifier,
+	Error_MissingExpression,
+	Error_ExpectedBoolExpression,
+	Error_ExpectedBody,
+	Error_ExpectedElseBody,
+	Error_UnmatchedBlockStart,
+	Error_UnexpectedIdentifier,
+	Error_ExpectedFunction,
+	Error_ExpectedFunctionFoundTrash,
+	Error_MissingReturnType,
+	Error_MissingFunctionName,
+	Error_MissingParameters,
+	Error_MissingFunctionBody,
+	//semantic check
+	Error_DifferentTypes,
+	Error_IncorectType,
+	Error_FunctionAsVariable,
+	Error_AlreadyDefined,
+	Error_NotDefined,
+	Error_MissingMain,
+	Error_MainNotVoid,
+	Error_MainWithParameters,
+	Error_MissingReturn,
+	Error_StringModified,
+	Error_AssignedType,
+	Error_VoidFunctionReturnsValue,
+	Error_MissingReturnValue,
+	Error_ReturnedType,
+	Error_ReturnOutsideFunction,
+	Error_ConditionNotBool,
+	Error_BreakOutsideCycle,
+	Error_MemberOfNonArray,
+	Error_IndexNotInteger,
+	Error_VariableAsFunction,
+	Error_ParametersCount,
+	Error_ParameterType,
+	Error_NotNumericOperand,
+	Error_NotBoolOperand,
+	ErrorCodesCount
+};
+
+//error as it was reported, its text is made only when errors are printed.
+//Arguments point to names and type names, which live until then.
+struct Diagnostic
+{
+	ErrorCode Code;
+	int Line;
+	int Column;
+	const char* Arguments[2];
+	char Symbol;
+	//errors counted for it
+	int Count;
+};
+
+//errors of a thread are kept here while it is set, so work done in parallel can report them in source order
+struct ErrorBuffer
+{
+	std::vector<Diagnostic> Errors;
+	int Count = 0;
+};
+
+//errors are recorded and printed together by printErrors. An error equal to the one reported
+//right before it is a cascade of it and is dropped, so are errors over the limit of setMaxErrors.
+//Errors can be reported from any thread.
 struct ErrorHandler
 {
-	static void printError(int lineNumber, const char* errorMessage, int lineOffset = 0);
+	static void printError(int lineNumber, ErrorCode code, const char* argument = nullptr, const char* secondArgument = nullptr);
+	//false when the error was dropped
+	static bool printLexError(int lineNumber, int lineOffset, ErrorCode code, char symbol);
+	//counts the last recorded error once more
+	static void countError();
+	//0 is no limit
+	static void setMaxErrors(int maxErrors);
+	//work which only reports more errors can stop, in a thread with a buffer it is the limit of the buffer alone
+	static bool limitReached();
+	static void setBuffer(ErrorBuffer* buffer);
+	//lines of errors reported by the thread are counted from base, as lines of nodes are in functions with a LineBase
+	static void setLineBase(int base);
+	//adds buffered errors from begin to end as if they were reported now
+	static void flush(const ErrorBuffer& buffer, size_t begin = 0, size_t end = (size_t)-1);
+	//adds errors whose lines are counted from lineBase as if they were reported now
+	static void flush(const std::vector<Diagnostic>& errors, int lineBase);
+	//text of the error without the file and line
+	static std::string message(const Diagnostic& error);
+	//prints errors recorded since the last call to stderr
+	static void printErrors();
+	//errors recorded since the last clear, printed or not
+	static std::vector<Diagnostic> recorded();
+	static void clear();
 };
 
 extern std::string fileName;
-extern int errorsCount;
\ No newline at end of file
+extern int errorsCount;
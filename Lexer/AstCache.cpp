@@ -0,0 +1,513 @@
+#include "pch.h"
+#include "AstCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+using namespace std;
+
+const char CacheMagic[4] = { 'L', 'A', 'S', 'T' };
+
+const unsigned long long HashOffset = 14695981039346656037ull;
+
+unsigned long long hash_text(unsigned long long hash, const char* text, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+unsigned long long hash_source(const string& text)
+{
+	return hash_text(HashOffset, text.data(), text.size());
+}
+
+unsigned long long build_tree_format_hash()
+{
+	unsigned long long hash = hash_text(HashOffset, (const char*)&AstCacheVersion, sizeof(AstCacheVersion));
+	hash = hash_text(hash, CompilerVersion, strlen(CompilerVersion) + 1);
+	for (const char* name : NodeKindNames)
+		hash = hash_text(hash, name, strlen(name) + 1);
+	vector<int> tables = lexer_tables();
+	return hash_text(hash, (const char*)tables.data(), tables.size() * sizeof(int));
+}
+
+unsigned long long tree_format_hash()
+{
+	static const unsigned long long hash = build_tree_format_hash();
+	return hash;
+}
+
+unsigned long long entry_key(const string& source)
+{
+	unsigned long long hash = hash_source(source);
+	unsigned long long format = tree_format_hash();
+	return hash_text(hash, (const char*)&format, sizeof(format));
+}
+
+//a node is written as its kind and its fields, the same code writes and reads the fields
+template<typename Archive> void transfer(Archive& archive, Node* node)
+{
+	archive.Int(node->LineNumber);
+	switch (node->Kind)
+	{
+	case Kind_Function:
+	{
+		Function* function = static_cast<Function*>(node);
+		archive.Child(node, function->ReturnType);
+		archive.Child(node, function->Name);
+		archive.Child(node, function->Parameters);
+		archive.Child(node, function->Body);
+		break;
+	}
+	case Kind_Identifier:
+		archive.Name(static_cast<Identifier*>(node)->Value);
+		break;
+	case Kind_BoolKeyword:
+	case Kind_IntegerKeyword:
+	case Kind_FloatKeyword:
+	case Kind_StringKeyword:
+	case Kind_CharKeyword:
+	case Kind_VoidKeyword:
+		archive.Flag(static_cast<TypeKeyword*>(node)->IsPointer);
+		break;
+	case Kind_ParamDef:
+	{
+		ParamDef* param = static_cast<ParamDef*>(node);
+		archive.Child(node, param->Type);
+		archive.Child(node, param->Name);
+		archive.Flag(param->HasSeperator);
+		break;
+	}
+	case Kind_FunctionParamsDef:
+		archive.List(node, static_cast<FunctionParamsDef*>(node)->Parameters);
+		archive.Flag(static_cast<FunctionParamsDef*>(node)->HasListEnd);
+		break;
+	case Kind_BlockBody:
+		archive.List(node, static_cast<BlockBody*>(node)->Statements);
+		archive.Flag(static_cast<BlockBody*>(node)->HasEnd);
+		break;
+	case Kind_EmptyStatement:
+	case Kind_BreakStatement:
+	case Kind_ContinueStatement:
+		archive.Flag(static_cast<EmptyStatement*>(node)->HasEndToken);
+		break;
+	case Kind_AssignmentNode:
+		archive.Child(node, static_cast<AssignmentNode*>(node)->Expression);
+		break;
+	case Kind_AssignmentStatement:
+	{
+		AssignmentStatement* statement = static_cast<AssignmentStatement*>(node);
+		archive.Flag(statement->HasEndToken);
+		archive.Child(node, statement->Variable);
+		archive.Child(node, statement->Assignment);
+		break;
+	}
+	case Kind_DeclarationStatement:
+	{
+		DeclarationStatement* statement = static_cast<DeclarationStatement*>(node);
+		archive.Flag(statement->HasEndToken);
+		archive.Child(node, statement->Type);
+		archive.Child(node, statement->Variable);
+		archive.Child(node, statement->Assignment);
+		archive.Child(node, statement->Size);
+		break;
+	}
+	case Kind_FunctionCallStatement:
+		archive.Flag(static_cast<FunctionCallStatement*>(node)->HasEndToken);
+		archive.Child(node, static_cast<FunctionCallStatement*>(node)->FunctionCall);
+		break;
+	case Kind_ReturnStatement:
+		archive.Flag(static_cast<ReturnStatement*>(node)->HasEndToken);
+		archive.Child(node, static_cast<ReturnStatement*>(node)->ReturnValue);
+		break;
+	case Kind_PrintNode:
+		archive.Child(node, static_cast<PrintNode*>(node)->Expression);
+		break;
+	case Kind_PrintStatement:
+		archive.Flag(static_cast<PrintStatement*>(node)->HasEndToken);
+		archive.List(node, static_cast<PrintStatement*>(node)->Prints);
+		break;
+	case Kind_ScanNode:
+		archive.Child(node, static_cast<ScanNode*>(node)->Identifier);
+		break;
+	case Kind_ScanStatement:
+		archive.Flag(static_cast<ScanStatement*>(node)->HasEndToken);
+		archive.List(node, static_cast<ScanStatement*>(node)->Scans);
+		break;
+	case Kind_WhileStatement:
+		archive.Child(node, static_cast<WhileStatement*>(node)->Condition);
+		archive.Child(node, static_cast<WhileStatement*>(node)->Body);
+		break;
+	case Kind_IfStatement:
+	{
+		IfStatement* statement = static_cast<IfStatement*>(node);
+		archive.Child(node, statement->Condition);
+		archive.Child(node, statement->Body);
+		archive.Child(node, statement->Else);
+		break;
+	}
+	case Kind_ElseIf:
+		archive.Child(node, static_cast<ElseIf*>(node)->If);
+		break;
+	case Kind_Else:
+		archive.Child(node, static_cast<Else*>(node)->ElseBody);
+		break;
+	case Kind_MultiplicationExpression:
+	case Kind_AddExpression:
+	case Kind_CompExpression:
+	case Kind_OrExpression:
+	case Kind_AndExpression:
+	{
+		BinaryExpression* expression = static_cast<BinaryExpression*>(node);
+		archive.Child(node, expression->Left);
+		archive.Child(node, expression->Right);
+		archive.Type(expression->Operator);
+		archive.Int(expression->OperatorLine);
+		break;
+	}
+	case Kind_IdentifierExpression:
+		archive.Name(static_cast<IdentifierExpression*>(node)->Value);
+		break;
+	case Kind_MemberAccessExpression:
+		archive.Name(static_cast<MemberAccessExpression*>(node)->Value);
+		archive.Child(node, static_cast<MemberAccessExpression*>(node)->AccessPosition);
+		break;
+	case Kind_FunctionCallExpression:
+		archive.Child(node, static_cast<FunctionCallExpression*>(node)->Name);
+		archive.Child(node, static_cast<FunctionCallExpression*>(node)->Parameters);
+		break;
+	case Kind_FunctionParams:
+		archive.List(node, static_cast<FunctionParams*>(node)->Parameters);
+		archive.Flag(static_cast<FunctionParams*>(node)->HasListEnd);
+		break;
+	case Kind_Param:
+		archive.Child(node, static_cast<Param*>(node)->Expression);
+		archive.Flag(static_cast<Param*>(node)->HasSeperator);
+		break;
+	case Kind_StringExpression:
+		archive.Text(static_cast<StringExpression*>(node)->Value);
+		break;
+	case Kind_CharExpression:
+		archive.Char(static_cast<CharExpression*>(node)->Value);
+		break;
+	case Kind_IntegerExpression:
+		archive.Int(static_cast<IntegerExpression*>(node)->Value);
+		break;
+	case Kind_FloatExpression:
+		archive.Real(static_cast<FloatExpression*>(node)->Value);
+		break;
+	case Kind_GroupedExpression:
+		archive.Child(node, static_cast<GroupedExpression*>(node)->Expression);
+		break;
+	case Kind_SubExpression:
+	case Kind_NotExpression:
+		archive.Child(node, static_cast<UnaryExpression*>(node)->Expression);
+		break;
+	default:
+		break;
+	}
+}
+
+//trees are written and read recursively, deeper ones are not cached
+const int MaxCachedDepth = 1000;
+
+struct TreeWriter
+{
+	string& Data;
+	bool Failed = false;
+	int Depth = 0;
+
+	TreeWriter(string& data) : Data(data) {}
+
+	void Unsigned(unsigned long long value)
+	{
+		while (value >= 0x80)
+		{
+			Data.push_back((char)(value | 0x80));
+			value >>= 7;
+		}
+		Data.push_back((char)value);
+	}
+	void Int(int& value) { Unsigned(((unsigned)value << 1) ^ (unsigned)(value >> 31)); }
+	void Flag(bool& value) { Data.push_back(value ? 1 : 0); }
+	void Char(char& value) { Data.push_back(value); }
+	void Type(LexemType& value) { Unsigned(value); }
+	void Name(Symbol& value) { Unsigned(value); }
+	void Real(double& value)
+	{
+		char bytes[sizeof(double)];
+		memcpy(bytes, &value, sizeof(double));
+		Data.append(bytes, sizeof(double));
+	}
+	void Text(const string& value)
+	{
+		Unsigned(value.size());
+		Data.append(value);
+	}
+
+	//parser leaves parent of a child either empty or the node owning it
+	void Tree(Node* owner, Node* node)
+	{
+		NodeKind tag = node == nullptr ? NoKind : node->Kind;
+		if (node != nullptr && (tag == NoKind || (node->parent != nullptr && node->parent != owner)))
+			Failed = true;
+		Data.push_back((char)tag);
+		if (tag == NoKind)
+			return;
+		if (Depth == MaxCachedDepth)
+		{
+			Failed = true;
+			return;
+		}
+		Data.push_back(node->parent != nullptr ? 1 : 0);
+		Depth++;
+		transfer(*this, node);
+		Depth--;
+	}
+	template<typename T> void Child(Node* owner, T*& child) { Tree(owner, child); }
+	template<typename T> void List(Node* owner, vector<T*>& items)
+	{
+		Unsigned(items.size());
+		for (T* item : items)
+			Tree(owner, item);
+	}
+};
+
+struct TreeReader
+{
+	const char* Position;
+	const char* End;
+	NodeArena& Nodes;
+	vector<Symbol> Symbols;
+	bool Failed = false;
+	int Depth = 0;
+
+	TreeReader(const string& data, size_t offset, NodeArena& nodes)
+		: Position(data.data() + offset), End(data.data() + data.size()), Nodes(nodes) {}
+
+	unsigned char Byte()
+	{
+		if (Position == End)
+		{
+			Failed = true;
+			return 0;
+		}
+		return (unsigned char)*Position++;
+	}
+	unsigned long long Unsigned()
+	{
+		unsigned long long value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			unsigned char byte = Byte();
+			value |= (unsigned long long)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+		Failed = true;
+		return 0;
+	}
+	//count of items that are at least a byte each
+	size_t Count()
+	{
+		unsigned long long count = Unsigned();
+		if (count > (unsigned long long)(End - Position))
+		{
+			Failed = true;
+			return 0;
+		}
+		return (size_t)count;
+	}
+	void Int(int& value)
+	{
+		unsigned coded = (unsigned)Unsigned();
+		value = (int)(coded >> 1) ^ -(int)(coded & 1);
+	}
+	void Flag(bool& value) { value = Byte() != 0; }
+	void Char(char& value) { value = (char)Byte(); }
+	void Type(LexemType& value)
+	{
+		unsigned long long type = Unsigned();
+		if (type > Error)
+			Failed = true;
+		else
+			value = (LexemType)type;
+	}
+	void Name(Symbol& value)
+	{
+		unsigned long long index = Unsigned();
+		if (index >= Symbols.size())
+			Failed = true;
+		else
+			value = Symbols[(size_t)index];
+	}
+	void Real(double& value)
+	{
+		if (End - Position < (ptrdiff_t)sizeof(double))
+		{
+			Failed = true;
+			return;
+		}
+		memcpy(&value, Position, sizeof(double));
+		Position += sizeof(double);
+	}
+	void Text(string& value)
+	{
+		size_t size = Count();
+		value.assign(Position, size);
+		Position += size;
+	}
+
+	//node is made with the type of its kind, which has to fit the field
+	template<typename T, typename N> T* Make(Node* owner)
+	{
+		if constexpr (is_base_of<T, N>::value)
+		{
+			if (Depth == MaxCachedDepth)
+			{
+				Failed = true;
+				return nullptr;
+			}
+			N* node = create_node<N>(Nodes);
+			if (Byte() != 0)
+				node->parent = owner;
+			Depth++;
+			transfer(*this, node);
+			Depth--;
+			return node;
+		}
+		else
+		{
+			Failed = true;
+			return nullptr;
+		}
+	}
+	template<typename T> void Child(Node* owner, T*& child)
+	{
+		child = nullptr;
+		NodeKind tag = (NodeKind)Byte();
+		if (Failed)
+			return;
+		switch (tag)
+		{
+		case NoKind:
+			break;
+		#define MAKE_NODE(CLASS) case Kind_ ## CLASS: child = Make<T, CLASS>(owner); break;
+		SYNTAX_NODES(MAKE_NODE)
+		#undef MAKE_NODE
+		default:
+			Failed = true;
+			break;
+		}
+	}
+	template<typename T> void List(Node* owner, vector<T*>& items)
+	{
+		size_t count = Count();
+		items.reserve(count);
+		for (size_t i = 0; i < count && !Failed; i++)
+		{
+			T* item = nullptr;
+			Child(owner, item);
+			items.push_back(item);
+		}
+	}
+};
+
+void write_header(string& data, const string& source)
+{
+	data.append(CacheMagic, sizeof(CacheMagic));
+	TreeWriter header(data);
+	header.Unsigned(AstCacheVersion);
+	header.Text(CompilerVersion);
+	header.Unsigned(tree_format_hash());
+	header.Unsigned(hash_source(source));
+	header.Unsigned(source.size());
+}
+
+bool write_tree(const SyntaxTree& tree, const string& source, string& data)
+{
+	data.clear();
+	write_header(data, source);
+	TreeWriter writer(data);
+	//symbols are written in the order they were interned, loading them again keeps them in the same order
+	writer.Unsigned(Symbols.Count());
+	for (size_t i = 0; i < Symbols.Count(); i++)
+		writer.Text(Symbols.Text((Symbol)i));
+	writer.Unsigned(tree.functions.size());
+	for (Function_Ptr function : tree.functions)
+		writer.Tree(nullptr, function);
+	return !writer.Failed;
+}
+
+SyntaxTree_Ptr read_tree(const string& data, const string& source)
+{
+	string header;
+	write_header(header, source);
+	if (data.compare(0, header.size(), header) != 0)
+		return nullptr;
+
+	SyntaxTree_Ptr tree = make_shared<SyntaxTree>();
+	TreeReader reader(data, header.size(), tree->Nodes);
+	size_t symbolsCount = reader.Count();
+	reader.Symbols.reserve(symbolsCount);
+	string text;
+	for (size_t i = 0; i < symbolsCount && !reader.Failed; i++)
+	{
+		reader.Text(text);
+		reader.Symbols.push_back(Symbols.Intern(text));
+	}
+	size_t functionsCount = reader.Count();
+	for (size_t i = 0; i < functionsCount && !reader.Failed; i++)
+	{
+		Function_Ptr function = nullptr;
+		reader.Child(nullptr, function);
+		tree->functions.push_back(function);
+	}
+	if (reader.Failed || reader.Position != reader.End)
+		return nullptr;
+	return tree;
+}
+
+AstCache::AstCache(const string& directory) : directory(directory)
+{
+}
+
+string AstCache::EntryPath(const string& source) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.ast", entry_key(source));
+	if (directory.empty() || directory.back() == '/' || directory.back() == '\\')
+		return directory + name;
+	return directory + "/" + name;
+}
+
+SyntaxTree_Ptr AstCache::Load(const string& source)
+{
+	ifstream file(EntryPath(source), ios::binary);
+	if (!file)
+		return nullptr;
+	//whole entry is read at once, nodes are made from it in one pass
+	file.seekg(0, ios::end);
+	streamoff size = file.tellg();
+	file.seekg(0, ios::beg);
+	string data((size_t)max<streamoff>(size, 0), '\0');
+	file.read(&data[0], data.size());
+	if (file.gcount() != (streamsize)data.size())
+		return nullptr;
+	return read_tree(data, source);
+}
+
+bool AstCache::Save(const string& source, const SyntaxTree& tree)
+{
+	string data;
+	if (!write_tree(tree, source, data))
+		return false;
+	ofstream file(EntryPath(source), ios::binary | ios::trunc);
+	file.write(data.data(), data.size());
+	return (bool)file;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pch.h"
+#include "SyntaxParser.h"
+
+//bump when the layout of entries changes, entries of older versions are then parsed again
+const unsigned AstCacheVersion = 2;
+
+//FNV-1a of the whole source text
+unsigned long long hash_source(const std::string& text);
+//FNV-1a of the format version, CompilerVersion, the node kinds and the lexer tables
+unsigned long long tree_format_hash();
+//entries are found by the source together with the tree format, a tree built by another compiler is never loaded
+unsigned long long entry_key(const std::string& source);
+
+//syntax trees of sources parsed without errors, kept in a directory and found by the hash of the source.
+//A loaded tree is the one the parser built, symbols of it are interned again.
+struct AstCache
+{
+	AstCache(const std::string& directory);
+
+	//nullptr when there is no valid entry for the source
+	SyntaxTree_Ptr Load(const std::string& source);
+	bool Save(const std::string& source, const SyntaxTree& tree);
+	std::string EntryPath(const std::string& source) const;
+
+private:
+	std::string directory;
+};
+
+//entry contents, false when some node of the tree cannot be written
+bool write_tree(const SyntaxTree& tree, const std::string& source, std::string& data);
+//nullptr when data is not an entry of the source
+SyntaxTree_Ptr read_tree(const std::string& data, const std::string& source);
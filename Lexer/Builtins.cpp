@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "Builtins.h"
+
+using namespace std;
+
+static TypeKeyword* make_type_keyword(ExpressionType type, NodeArena& nodes)
+{
+	TypeKeyword* keyword = nullptr;
+	switch (type)
+	{
+	case BoolType:
+	case BoolPointer:
+		keyword = create_node<BoolKeyword>(nodes);
+		break;
+	case IntType:
+	case IntPointer:
+		keyword = create_node<IntegerKeyword>(nodes);
+		break;
+	case FloatType:
+	case FloatPointer:
+		keyword = create_node<FloatKeyword>(nodes);
+		break;
+	case StringType:
+		keyword = create_node<StringKeyword>(nodes);
+		break;
+	case CharType:
+	case CharPointer:
+		keyword = create_node<CharKeyword>(nodes);
+		break;
+	default:
+		keyword = create_node<VoidKeyword>(nodes);
+		break;
+	}
+	keyword->IsPointer = type == BoolPointer || type == IntPointer || type == FloatPointer || type == CharPointer;
+
+	return keyword;
+}
+
+struct BuiltinFunctions
+{
+	NodeArena Nodes;
+	Function* Functions[BuiltinsCount];
+
+	BuiltinFunctions()
+	{
+		for (size_t i = 0; i < BuiltinsCount; i++)
+		{
+			const Builtin& builtin = Builtins[i];
+			auto function = create_node<Function>(Nodes);
+			function->Name = create_node<Identifier>(Nodes);
+			function->Name->Value = FirstBuiltinSymbol + (Symbol)i;
+			function->ReturnType = make_type_keyword(builtin.ReturnType, Nodes);
+			function->HasReturn = true;
+			function->Parameters = create_node<FunctionParamsDef>(Nodes);
+			for (size_t j = 0; j < MaxBuiltinParameters && builtin.Parameters[j] != Unknown; j++)
+			{
+				auto param = create_node<ParamDef>(Nodes);
+				param->Type = make_type_keyword(builtin.Parameters[j], Nodes);
+				function->Parameters->Parameters.push_back(param);
+			}
+			Functions[i] = function;
+		}
+	}
+};
+
+Function* builtin_function(int index)
+{
+	//made on first use, functions outlive every syntax tree
+	static BuiltinFunctions functions;
+	return functions.Functions[index];
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "pch.h"
+#include "SyntaxParser.h"
+
+const size_t MaxBuiltinParameters = 4;
+
+//functions every program can call without declaring them, new builtins only need an entry here.
+//Code is 8086 code called like compiled functions: parameters are on the stack and popped by the builtin.
+struct Builtin
+{
+	std::string_view Name;
+	ExpressionType ReturnType;
+	//parameters end at the first Unknown
+	ExpressionType Parameters[MaxBuiltinParameters];
+	const unsigned char* Code;
+	size_t CodeSize;
+};
+
+//clock tick count from int 1Ah modulo the parameter
+constexpr unsigned char RandCode[] = {
+	0x55, 0x8b, 0xec, 0xb8, 0x00, 0x00, 0xcd, 0x1a, 0x8b, 0xc2, 0x33, 0xd2,
+	0x8b, 0x4e, 0x04, 0xf7, 0xf1, 0x8b, 0xc2, 0x5d, 0xc2, 0x02, 0x00
+};
+//busy loop counting the parameter down
+constexpr unsigned char SleepCode[] = {
+	0x55, 0x8b, 0xec, 0x8b, 0x46, 0x04, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90,
+	0x90, 0x90, 0x48, 0x3d, 0x00, 0x00, 0x75, 0xf2, 0x5d, 0xc2, 0x02, 0x00
+};
+//moves the cursor with int 10h to the row and column given by the parameters
+constexpr unsigned char SetscreenCode[] = {
+	0x55, 0x8b, 0xec, 0x8a, 0x76, 0x04, 0x8a, 0x56, 0x06, 0xb8, 0x00, 0x02,
+	0xcd, 0x10, 0x5d, 0xc2, 0x04, 0x00
+};
+
+constexpr Builtin Builtins[] = {
+	{ "rand", IntType, { IntType }, RandCode, sizeof(RandCode) },
+	{ "sleep", VoidType, { IntType }, SleepCode, sizeof(SleepCode) },
+	{ "setscreen", VoidType, { IntType, IntType }, SetscreenCode, sizeof(SetscreenCode) }
+};
+constexpr size_t BuiltinsCount = sizeof(Builtins) / sizeof(Builtins[0]);
+
+//names of builtins are interned right after the known symbols in the order of Builtins,
+//so the index of a builtin is its symbol less FirstBuiltinSymbol. -1 when the name is not a builtin.
+inline int builtin_index(Symbol name)
+{
+	size_t index = (size_t)(name - FirstBuiltinSymbol);
+	return index < BuiltinsCount ? (int)index : -1;
+}
+
+//declaration of the builtin checked against calls, made once and shared by all syntax trees and threads,
+//so it is only read. Code generation keeps the addresses of builtins in ProgramCode.
+Function* builtin_function(int index);
@@ -6,40 +6,44 @@ using namespace std;
 
 const int COM_ENTRY_POINT = 0x100;
 
-int GetTypeSize(ExpressionType type)
+void ProgramCode::AddFunction(Symbol name, Function* function)
 {
-	switch (type)
-	{
-	case FloatType:
-		return 4;
-	case IntType:
-	case StringType:
-		return 2;
-	case CharType:
-	case BoolType:
-		return 1;
-	default:
-		return 2;
-	}
+	functions.insert(std::pair<Symbol, Function*>(name, function));
+}
+
+InstructionOperand_Ptr ProgramCode::FunctionAddress(Symbol name)
+{
+	auto function = functions.find(name);
+	if (function != functions.end())
+		return StartAddress(function->second);
+
+	InstructionOperand_Ptr& address = BuiltinAddresses[builtin_index(name)];
+	if (address == nullptr)
+		address = make_shared<InstructionOperand>();
+	return address;
 }
 
-void ProgramCode::AddFunction(std::string name, Function* function)
+template<typename Key> InstructionOperand_Ptr& address_of(unordered_map<Key, InstructionOperand_Ptr>& addresses, Key node)
 {
-	functions.insert(std::pair<std::string, Function*>(name, function));
+	InstructionOperand_Ptr& address = addresses[node];
+	if (address == nullptr)
+		address = make_shared<InstructionOperand>();
+	return address;
 }
 
-void ProgramCode::AddVariable(string name, VariableDeclaration* variable, int additionalSpace = 0)
+InstructionOperand_Ptr& ProgramCode::FalseJmpAddress(ConditionalNode* node)
 {
-	functionVariables.insert(std::pair<std::string, VariableDeclaration*>(name, variable));
-	currentRelativeAddress -= GetTypeSize(variable->Type->getType()) + additionalSpace;
-	variable->relativeAddress = currentRelativeAddress;
+	return address_of(falseJmpAddresses, node);
 }
 
-void ProgramCode::AddParam(string name, VariableDeclaration* variable)
+InstructionOperand_Ptr& ProgramCode::StartAddress(Node* node)
 {
-	functionVariables.insert(std::pair<std::string, VariableDeclaration*>(name, variable));
-	paramRelativeAddress += 2;
-	variable->relativeAddress = paramRelativeAddress;
+	return address_of(startAddresses, node);
+}
+
+InstructionOperand_Ptr& ProgramCode::EndAddress(Node* node)
+{
+	return address_of(endAddresses, node);
 }
 
 void ProgramCode::AddInstruction(Instruction_Ptr instruction)
@@ -48,16 +52,12 @@ void ProgramCode::AddInstruction(Instruction_Ptr instruction)
 	Instructions.push_back(instruction);
 }
 
-void ProgramCode::IncludeRezervedFunction(string name)
+void ProgramCode::IncludeRezervedFunction(Symbol name)
 {
-	std::ifstream file(name.c_str(), std::ios::binary);
-	char c;
-	while ((c = file.get()) != EOF)
-	{
-		currentAddress++;
-		RezervedFunctionsCode.push_back(c);
-	}
-	file.close();
+	const Builtin& builtin = Builtins[builtin_index(name)];
+	FunctionAddress(name)->value = currentAddress;
+	RezervedFunctionsCode.insert(RezervedFunctionsCode.end(), builtin.Code, builtin.Code + builtin.CodeSize);
+	currentAddress += (int)builtin.CodeSize;
 }
 
 void ProgramCode::Print()
@@ -124,41 +124,8 @@ void ProgramCode::Print()
 	file.close();
 }
 
-ConditionalNode* Node::findConditionalNodeParent()
-{
-	auto nodeParent = parent;
-	while (nodeParent != nullptr)
-	{
-		auto conditionalNode = dynamic_cast<ConditionalNode*>(&(*nodeParent));
-		if (conditionalNode != nullptr)
-		{
-			return conditionalNode;
-		}
-		nodeParent = nodeParent->parent;
-	}
-
-	return nullptr;
-}
-
-NotExpression* Node::findNotParent()
-{
-	auto nodeParent = parent;
-	while (nodeParent != nullptr)
-	{
-		auto notExpression = dynamic_cast<NotExpression*>(&(*nodeParent));
-		if (notExpression != nullptr)
-		{
-			return notExpression;
-		}
-		nodeParent = nodeParent->parent;
-	}
-
-	return nullptr;
-}
-
 void SyntaxTree::generateCode(ProgramCode_Ptr programCode)
 {
-	Function_Ptr mainFunction = nullptr;
 	auto callInstruction = make_shared<CallInstruction>();
 	programCode->AddInstruction(callInstruction); 
 	callInstruction->Operands.push_back(make_shared<InstructionOperand>(programCode->currentAddress));
@@ -175,26 +142,18 @@ void SyntaxTree::generateCode(ProgramCode_Ptr programCode)
 	{
 		programCode->AddFunction(function->Name->Value, &(*function));
 	}
-	for (auto rezervedFunction : rezervedFunctions)
-	{
-		programCode->AddFunction(rezervedFunction->Name->Value, &(*rezervedFunction));
-	}
 	for (auto function : functions)
 	{
-		programCode->currentRelativeAddress = 0;
-		programCode->paramRelativeAddress = 2;
-		programCode->functionVariables.clear();
 		if (function->IsMain)
 		{
-			callInstruction->Operands.push_back(function->functionStartAddress);
+			callInstruction->Operands.push_back(programCode->StartAddress(function));
 		}
-		function->functionStartAddress->value = programCode->currentAddress;
+		programCode->StartAddress(function)->value = programCode->currentAddress;
 		function->generateCode(programCode);
 	}
 
 	for (auto rezervedFunction : rezervedFunctions)
 	{
-		rezervedFunction->functionStartAddress->value = programCode->currentAddress;
 		programCode->IncludeRezervedFunction(rezervedFunction->Name->Value);
 	}
 
@@ -229,14 +188,10 @@ void Function::generateCode(ProgramCode_Ptr program)
 	program->AddInstruction(instruction);
 	auto label = make_shared<InstructionOperand>();
 	instruction->Operands.push_back(label);
-	for(auto param = Parameters->Parameters.rbegin(); param != Parameters->Parameters.rend(); param++)
-	{
-		program->AddParam((*param)->Name->Value, dynamic_cast<VariableDeclaration *>(&(**param)));
-	}
 	Body->generateCode(program);
-	label->value = -(program->currentRelativeAddress);
+	label->value = FrameSize;
 
-	functionEndAddress->value = program->currentAddress;
+	program->EndAddress(this)->value = program->currentAddress;
 	instruction = make_shared<MovWordInstruction>(Register);
 	program->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(SP));
@@ -246,7 +201,7 @@ void Function::generateCode(ProgramCode_Ptr program)
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BP));
 	instruction = make_shared<ReturnInstruction>();
 	program->AddInstruction(instruction);
-	instruction->Operands.push_back(make_shared<InstructionOperand>(program->paramRelativeAddress - 2));
+	instruction->Operands.push_back(make_shared<InstructionOperand>(2 * (int)Parameters->Parameters.size()));
 }
 
 void BlockBody::generateCode(ProgramCode_Ptr code)
@@ -259,8 +214,10 @@ void BlockBody::generateCode(ProgramCode_Ptr code)
 
 void AssignmentStatement::generateCode(ProgramCode_Ptr code)
 {
+	code->Conditionals.push_back(this);
 	Assignment->Expression->generateCode(code);
 	Variable->setData(code, Assignment->Expression->Type);
+	code->Conditionals.pop_back();
 	auto reg = make_shared<InstructionOperand>(Variable->AccessRegister);
 	auto mod = (Mod)Variable->AccessMod;
 
@@ -276,8 +233,8 @@ void AssignmentStatement::generateCode(ProgramCode_Ptr code)
 
 		instruction = make_shared<JMPInstruction>();
 		code->AddInstruction(instruction);
-		instruction->Operands.push_back(falseJmpAddress);
-		falseJmpAddress->value = code->currentAddress;
+		instruction->Operands.push_back(code->FalseJmpAddress(this));
+		code->FalseJmpAddress(this)->value = code->currentAddress;
 		auto jumpOutOp = make_shared<InstructionOperand>();
 		instruction->Operands.push_back(jumpOutOp);
 
@@ -312,11 +269,6 @@ void AssignmentStatement::generateCode(ProgramCode_Ptr code)
 
 void DeclarationStatement::generateCode(ProgramCode_Ptr code)
 {
-	int size = 0;
-	if(Size != nullptr)
-		size = Size->Value * Type->getSize();
-
-	code->AddVariable(Variable->Value, this, size);
 	auto reg = make_shared<InstructionOperand>(XX_BP);
 	auto op = make_shared<InstructionOperand>();
 	op->value = relativeAddress;
@@ -336,7 +288,9 @@ void DeclarationStatement::generateCode(ProgramCode_Ptr code)
 	}
 	if (Assignment != nullptr)
 	{
+		code->Conditionals.push_back(this);
 		Assignment->Expression->generateCode(code);
+		code->Conditionals.pop_back();
 		if (Type->getType() == BoolType)
 		{
 			Instruction_Ptr instruction = make_shared<MovByteConstInstruction>(MemoryRelative);
@@ -348,7 +302,7 @@ void DeclarationStatement::generateCode(ProgramCode_Ptr code)
 			instruction = make_shared<JMPInstruction>();
 			code->AddInstruction(instruction);
 			instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-			falseJmpAddress->value = code->currentAddress;
+			code->FalseJmpAddress(this)->value = code->currentAddress;
 			auto jumpOutOp = make_shared<InstructionOperand>();
 			instruction->Operands.push_back(jumpOutOp);
 
@@ -387,7 +341,9 @@ void ReturnStatement::generateCode(ProgramCode_Ptr code)
 {
 	if (ReturnValue != nullptr)
 	{
+		code->Conditionals.push_back(this);
 		ReturnValue->generateCode(code);
+		code->Conditionals.pop_back();
 		if (ReturnValue->Type == BoolType)
 		{
 			Instruction_Ptr instruction = make_shared<MovWordConstInstruction>(Register);
@@ -399,7 +355,7 @@ void ReturnStatement::generateCode(ProgramCode_Ptr code)
 			code->AddInstruction(instruction);
 			instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
 			auto jumpOutOp = make_shared<InstructionOperand>();
-			falseJmpAddress->value = code->currentAddress;
+			code->FalseJmpAddress(this)->value = code->currentAddress;
 			instruction->Operands.push_back(jumpOutOp);
 
 			instruction = make_shared<MovWordConstInstruction>(Register);
@@ -412,7 +368,7 @@ void ReturnStatement::generateCode(ProgramCode_Ptr code)
 	auto instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	instruction->Operands.push_back(findFunctionParent()->functionEndAddress);
+	instruction->Operands.push_back(code->EndAddress(ParentFunction));
 }
 
 void PrintStatement::generateCode(ProgramCode_Ptr code)
@@ -445,7 +401,7 @@ void ScanStatement::generateCode(ProgramCode_Ptr code)
 	//TODO: not only char
 	for (auto scan : Scans)
 	{
-		auto expressionType = code->functionVariables[scan->Identifier->Value]->Type->getType();
+		auto expressionType = scan->Identifier->Declaration->Type->getType();
 		auto ax_register = make_shared<InstructionOperand>(AX);
 
 		//TODO: interupt to check if char available
@@ -545,8 +501,7 @@ void BreakStatement::generateCode(ProgramCode_Ptr code)
 	auto instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	auto whileStatement = findCycleParent();
-	instruction->Operands.push_back(whileStatement->statementEndAddress);
+	instruction->Operands.push_back(code->FalseJmpAddress(ParentCycle));
 }
 
 void ContinueStatement::generateCode(ProgramCode_Ptr code)
@@ -554,29 +509,30 @@ void ContinueStatement::generateCode(ProgramCode_Ptr code)
 	auto instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	auto whileStatement = findCycleParent();
-	instruction->Operands.push_back(whileStatement->statementStartAddress);
+	instruction->Operands.push_back(code->StartAddress(ParentCycle));
 }
 
 void WhileStatement::generateCode(ProgramCode_Ptr code)
 {
-	falseJmpAddress = statementEndAddress;
-	statementStartAddress->value = code->currentAddress;
+	code->StartAddress(this)->value = code->currentAddress;
+	code->Conditionals.push_back(this);
 	Condition->generateCode(code);
 
 	Body->generateCode(code);
+	code->Conditionals.pop_back();
 	Instruction_Ptr instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	instruction->Operands.push_back(statementStartAddress);
-	statementEndAddress->value = code->currentAddress;
+	instruction->Operands.push_back(code->StartAddress(this));
+	code->FalseJmpAddress(this)->value = code->currentAddress;
 }
 
 void IfStatement::generateCode(ProgramCode_Ptr code)
 {
+	code->Conditionals.push_back(this);
 	Condition->generateCode(code);
 	Body->generateCode(code);
-	falseJmpAddress->value = code->currentAddress;
+	code->FalseJmpAddress(this)->value = code->currentAddress;
 
 	if (Else != nullptr)
 	{
@@ -587,11 +543,12 @@ void IfStatement::generateCode(ProgramCode_Ptr code)
 			code->AddInstruction(instruction);
 			instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
 			instruction->Operands.push_back(elseEnd);
-			falseJmpAddress->value = code->currentAddress;
+			code->FalseJmpAddress(this)->value = code->currentAddress;
 		}
 		Else->generateCode(code);
 		elseEnd->value = code->currentAddress;
 	}
+	code->Conditionals.pop_back();
 }
 
 void ElseIf::generateCode(ProgramCode_Ptr code)
@@ -604,14 +561,41 @@ void Else::generateCode(ProgramCode_Ptr code)
 	ElseBody->generateCode(code);
 }
 
-void BinaryExpression::generateCode(ProgramCode_Ptr code)
+//nested expressions are generated by this loop, not by recursion, so deep expressions do not use the call stack
+void Expression::generateCode(ProgramCode_Ptr code)
 {
-	Left->generateCode(code);
-	Instruction_Ptr instruction = make_shared<PushInstruction>();
-	code->AddInstruction(instruction);
-	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
+	vector<ExpressionFrame> frames;
+	frames.push_back(ExpressionFrame(this));
+	while (!frames.empty())
+	{
+		ExpressionFrame& frame = frames.back();
+		Expression_Ptr next = frame.Owner->generateStep(code, frame);
+		if (next != nullptr)
+			frames.push_back(ExpressionFrame(next));
+		else
+			frames.pop_back();
+	}
+}
+
+Expression_Ptr Expression::generateStep(ProgramCode_Ptr, ExpressionFrame&)
+{
+	throw std::exception("Expression::generateCode should never be called.");
+}
+
+Expression_Ptr BinaryExpression::generateOperands(ProgramCode_Ptr code, ExpressionFrame& frame)
+{
+	Instruction_Ptr instruction;
+	switch (frame.Stage++)
+	{
+	case 0:
+		return Left;
+	case 1:
+		instruction = make_shared<PushInstruction>();
+		code->AddInstruction(instruction);
+		instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
+		return Right;
+	}
 
-	Right->generateCode(code);
 	instruction = make_shared<PopInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
@@ -625,12 +609,15 @@ void BinaryExpression::generateCode(ProgramCode_Ptr code)
 	//instruction = make_shared<PushFloatInstruction>(Memory);
 	//code->AddInstruction(instruction);
 	//instruction->Operands.push_back(make_shared<InstructionOperand>(XX_SI));
+	return nullptr;
 }
 
-void MultiplicationExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr MultiplicationExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
 	//TODO: [possible optimization] then working with contants use constant
-	BinaryExpression::generateCode(code);
+	Expression_Ptr operand = generateOperands(code, frame);
+	if (operand != nullptr)
+		return operand;
 	auto instruction = make_shared<MultInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
@@ -639,24 +626,41 @@ void MultiplicationExpression::generateCode(ProgramCode_Ptr code)
 	//	auto instruction = make_shared<MulFloatInstruction>(Memory);
 	//	code->AddInstruction(instruction);
 	//}
+	return nullptr;
 }
 
-void AddExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr AddExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
 	//TODO: [possible optimization] then working with contants use constant
-	BinaryExpression::generateCode(code);
+	Expression_Ptr operand = generateOperands(code, frame);
+	if (operand != nullptr)
+		return operand;
 	auto instruction = make_shared<AddInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
 	//TODO: add floats
+	return nullptr;
 }
 
-void CompExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr CompExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
 	//TODO: compare chars
-	if (Right->Type == BoolType)
+	if (frame.Stage == 0)
+		code->Conditionals.push_back(this);
+	if (Right->Type != BoolType)
+	{
+		Expression_Ptr operand = generateOperands(code, frame);
+		if (operand != nullptr)
+			return operand;
+	}
+	else if (frame.Stage == 0)
 	{
-		Left->generateCode(code);
+		frame.Stage = 1;
+		return Left;
+	}
+	else if (frame.Stage == 1)
+	{
+		frame.Stage = 2;
 		auto usedRegister = make_shared<InstructionOperand>(AX);
 		Instruction_Ptr instruction = make_shared<MovWordConstInstruction>(Register);
 		code->AddInstruction(instruction);
@@ -670,7 +674,7 @@ void CompExpression::generateCode(ProgramCode_Ptr code)
 		instruction = make_shared<JMPInstruction>();
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-		falseJmpAddress->value = code->currentAddress;
+		code->FalseJmpAddress(this)->value = code->currentAddress;
 		auto jumpOutOp = make_shared<InstructionOperand>();
 		instruction->Operands.push_back(jumpOutOp);
 
@@ -684,9 +688,13 @@ void CompExpression::generateCode(ProgramCode_Ptr code)
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(usedRegister);
 
-		falseJmpAddress = make_shared<InstructionOperand>();
-		Right->generateCode(code);
-		instruction = make_shared<MovWordConstInstruction>(Register);
+		code->FalseJmpAddress(this) = make_shared<InstructionOperand>();
+		return Right;
+	}
+	else
+	{
+		auto usedRegister = make_shared<InstructionOperand>(AX);
+		Instruction_Ptr instruction = make_shared<MovWordConstInstruction>(Register);
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(usedRegister);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(1));
@@ -694,8 +702,8 @@ void CompExpression::generateCode(ProgramCode_Ptr code)
 		instruction = make_shared<JMPInstruction>();
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-		falseJmpAddress->value = code->currentAddress;
-		jumpOutOp = make_shared<InstructionOperand>();
+		code->FalseJmpAddress(this)->value = code->currentAddress;
+		auto jumpOutOp = make_shared<InstructionOperand>();
 		instruction->Operands.push_back(jumpOutOp);
 
 		instruction = make_shared<MovWordConstInstruction>(Register);
@@ -708,46 +716,43 @@ void CompExpression::generateCode(ProgramCode_Ptr code)
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
 	}
-	else
-	{
-		BinaryExpression::generateCode(code);
-	}
+	code->Conditionals.pop_back();
 
 	Instruction_Ptr instruction = make_shared<CmpWordInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
 
-	bool doInvert = findNotParent() != nullptr;
-	if (typeid(*Operator) == typeid(OpEq))
+	bool doInvert = code->InsideNot();
+	if (Operator == Op_eq)
 	{
 		if (doInvert)
 			instruction = make_shared<CondJmpInstruction>(JE);
 		else
 			instruction = make_shared<CondJmpInstruction>(JNE);
 	}
-	else if (typeid(*Operator) == typeid(OpNotEq))
+	else if (Operator == Op_noteq)
 	{
 		if (doInvert)
 			instruction = make_shared<CondJmpInstruction>(JNE);
 		else
 			instruction = make_shared<CondJmpInstruction>(JE);
 	}
-	else if (typeid(*Operator) == typeid(OpLess))
+	else if (Operator == Op_less)
 	{
 		if (doInvert)
 			instruction = make_shared<CondJmpInstruction>(JL);
 		else
 			instruction = make_shared<CondJmpInstruction>(JGE);
 	}
-	else if (typeid(*Operator) == typeid(OpLessEq))
+	else if (Operator == Op_lesseq)
 	{
 		if (doInvert)
 			instruction = make_shared<CondJmpInstruction>(JLE);
 		else
 			instruction = make_shared<CondJmpInstruction>(JG);
 	}
-	else if (typeid(*Operator) == typeid(OpMore))
+	else if (Operator == Op_more)
 	{
 		if (doInvert)
 			instruction = make_shared<CondJmpInstruction>(JG);
@@ -777,53 +782,56 @@ void CompExpression::generateCode(ProgramCode_Ptr code)
 	instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	auto condParent = findConditionalNodeParent();
-	instruction->Operands.push_back(condParent->falseJmpAddress);
+	auto condParent = code->ParentConditional();
+	instruction->Operands.push_back(code->FalseJmpAddress(condParent));
 	trueLoc->value = code->currentAddress;
+	return nullptr;
 }
 
-void or_generate_code(BinaryExpression* orExpression, ConditionalNode* condNode, ProgramCode_Ptr code)
+//true left operand jumps over the right one, the returned operand is set to the end of the right one
+InstructionOperand_Ptr or_between_operands(ConditionalNode* condNode, ConditionalNode* condParent, ProgramCode_Ptr code)
 {
-	orExpression->Left->generateCode(code);
 	auto instruction = make_shared<JMPInstruction>(); //jump to the end of or
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
 	auto orEndOp = make_shared<InstructionOperand>();
 	instruction->Operands.push_back(orEndOp);
-	condNode->falseJmpAddress->value = code->currentAddress;
+	code->FalseJmpAddress(condNode)->value = code->currentAddress;
 
-	auto condParent = orExpression->findConditionalNodeParent();
-	condNode->falseJmpAddress = condParent->falseJmpAddress;
-	orExpression->Right->generateCode(code);
-	orEndOp->value = code->currentAddress;
+	code->FalseJmpAddress(condNode) = code->FalseJmpAddress(condParent);
+	return orEndOp;
 }
 
-void OrExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr logical_generate_step(BinaryExpression* expression, ConditionalNode* condNode, bool isOr, ProgramCode_Ptr code, ExpressionFrame& frame)
 {
-	
-	if (findNotParent() != nullptr)
-	{
-		Left->generateCode(code);
-		Right->generateCode(code);
-	}
-	else
+	switch (frame.Stage++)
 	{
-		or_generate_code(this, this, code);
+	case 0:
+		frame.CondParent = code->ParentConditional();
+		code->Conditionals.push_back(condNode);
+		return expression->Left;
+	case 1:
+		if (isOr)
+			frame.Operand = or_between_operands(condNode, frame.CondParent, code);
+		return expression->Right;
 	}
+
+	if (frame.Operand != nullptr)
+		frame.Operand->value = code->currentAddress;
+	code->Conditionals.pop_back();
+	return nullptr;
 }
 
-void AndExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr OrExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
-	falseJmpAddress = findConditionalNodeParent()->falseJmpAddress;
-	if(findNotParent() != nullptr)
-	{
-		or_generate_code(this, this, code);
-	}
-	else
-	{
-		Left->generateCode(code);
-		Right->generateCode(code);
-	}
+	return logical_generate_step(this, this, !code->InsideNot(), code, frame);
+}
+
+Expression_Ptr AndExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
+{
+	if (frame.Stage == 0)
+		code->FalseJmpAddress(this) = code->FalseJmpAddress(code->ParentConditional());
+	return logical_generate_step(this, this, code->InsideNot(), code, frame);
 }
 
 void IdentifierExpression::setData(ProgramCode_Ptr code, ExpressionType type)
@@ -831,19 +839,24 @@ void IdentifierExpression::setData(ProgramCode_Ptr code, ExpressionType type)
 	AccessRegister = XX_BP;
 	AccessMod = MemoryRelative;
 	Offset = make_shared<InstructionOperand>();
-	auto variable = code->functionVariables[Value];
-	Offset->value = variable->relativeAddress;
+	Offset->value = Slot;
 }
 
-void IdentifierExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr IdentifierExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
 	setData(code, Type);
+	loadValue(code);
+	return nullptr;
+}
+
+void IdentifierExpression::loadValue(ProgramCode_Ptr code)
+{
 	auto mod = (Mod)AccessMod;
 	auto reg = make_shared<InstructionOperand>(AccessRegister);
 	Instruction_Ptr instruction;
 	if (Type == BoolType)
 	{
-		auto condParent = findConditionalNodeParent();
+		auto condParent = code->ParentConditional();
 		instruction = make_shared<MovByteInstruction>(mod, false);
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(reg);
@@ -857,13 +870,13 @@ void IdentifierExpression::generateCode(ProgramCode_Ptr code)
 		instruction->Operands.push_back(operand);
 		instruction->Operands.push_back(operand);
 
-		if (findNotParent() != nullptr)
+		if (code->InsideNot())
 			instruction = make_shared<CondJmpInstruction>(JNE);
 		else
 			instruction = make_shared<CondJmpInstruction>(JE);
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-		instruction->Operands.push_back(condParent->falseJmpAddress);
+		instruction->Operands.push_back(code->FalseJmpAddress(condParent));
 	}
 	else if (Type == CharType)
 	{
@@ -890,7 +903,28 @@ void IdentifierExpression::generateCode(ProgramCode_Ptr code)
 	}
 }
 
+Expression_Ptr MemberAccessExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
+{
+	if (frame.Stage++ == 0)
+	{
+		enterAccess(code, frame);
+		return AccessPosition;
+	}
+
+	leaveAccess(code, Type, frame);
+	loadValue(code);
+	return nullptr;
+}
+
 void MemberAccessExpression::setData(ProgramCode_Ptr code, ExpressionType type)
+{
+	ExpressionFrame frame(this);
+	enterAccess(code, frame);
+	AccessPosition->generateCode(code);
+	leaveAccess(code, type, frame);
+}
+
+void MemberAccessExpression::enterAccess(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
 	AccessRegister = BX_SI;
 	AccessMod = Memory;
@@ -901,7 +935,18 @@ void MemberAccessExpression::setData(ProgramCode_Ptr code, ExpressionType type)
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(ax_register);
 
-	AccessPosition->generateCode(code);
+	//index is not in conditions and not expressions around the access
+	swap(frame.Conditionals, code->Conditionals);
+	frame.NotsCount = code->NotsCount;
+	code->NotsCount = 0;
+}
+
+void MemberAccessExpression::leaveAccess(ProgramCode_Ptr code, ExpressionType type, ExpressionFrame& frame)
+{
+	swap(frame.Conditionals, code->Conditionals);
+	code->NotsCount = frame.NotsCount;
+	auto ax_register = make_shared<InstructionOperand>(AX);
+	Instruction_Ptr instruction;
 	int typeSize = GetTypeSize(type);
 	if (typeSize != 1)
 	{
@@ -923,9 +968,8 @@ void MemberAccessExpression::setData(ProgramCode_Ptr code, ExpressionType type)
 	instruction = make_shared<MovWordInstruction>(MemoryRelative, false);
 	code->AddInstruction(instruction);
 	Offset = nullptr;
-	auto variable = code->functionVariables[Value];
 	instruction->Operands.push_back(make_shared<InstructionOperand>(XX_BP));
-	instruction->Operands.push_back(make_shared<InstructionOperand>(variable->relativeAddress));
+	instruction->Operands.push_back(make_shared<InstructionOperand>(Slot));
 	instruction->Operands.push_back(make_shared<InstructionOperand>(BX));
 
 	//restore data
@@ -934,21 +978,25 @@ void MemberAccessExpression::setData(ProgramCode_Ptr code, ExpressionType type)
 	instruction->Operands.push_back(ax_register);
 }
 
-void FunctionCallExpression::generateCode(ProgramCode_Ptr code)
+//stage k pushes the parameter k - 1 generated before it
+Expression_Ptr FunctionCallExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
-	for (auto param : Parameters->Parameters)
+	Instruction_Ptr instruction;
+	if (frame.Stage > 0)
 	{
-		param->Expression->generateCode(code);
-		Instruction_Ptr instruction = make_shared<PushInstruction>();
+		instruction = make_shared<PushInstruction>();
 		code->AddInstruction(instruction);
 		instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 	}
-	Instruction_Ptr instruction = make_shared<CallInstruction>();
+	if (frame.Stage < (int)Parameters->Parameters.size())
+		return Parameters->Parameters[frame.Stage++]->Expression;
+
+	instruction = make_shared<CallInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	instruction->Operands.push_back(code->functions[Name->Value]->functionStartAddress);
+	instruction->Operands.push_back(code->FunctionAddress(Name->Value));
 
-	auto condParent = findConditionalNodeParent();
+	auto condParent = code->ParentConditional();
 	if (Type == BoolType && condParent != nullptr)
 	{
 		instruction = make_shared<TestWordInstruction>();
@@ -957,17 +1005,18 @@ void FunctionCallExpression::generateCode(ProgramCode_Ptr code)
 		instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 
 		Instruction_Ptr jmpInstruction;
-		if (findNotParent() != nullptr)
+		if (code->InsideNot())
 			jmpInstruction = make_shared<CondJmpInstruction>(JNE);
 		else
 			jmpInstruction = make_shared<CondJmpInstruction>(JE);
 		code->AddInstruction(jmpInstruction);
 		jmpInstruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-		jmpInstruction->Operands.push_back(condParent->falseJmpAddress);
+		jmpInstruction->Operands.push_back(code->FalseJmpAddress(condParent));
 	}
+	return nullptr;
 }
 
-void StringExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr StringExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
 	auto string = make_shared<StringConstant>(Value);
 	code->StringConstants.push_back(string);
@@ -976,25 +1025,28 @@ void StringExpression::generateCode(ProgramCode_Ptr code)
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 	instruction->Operands.push_back(string);
+	return nullptr;
 }
 
-void CharExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr CharExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
 	auto instruction = make_shared<MovWordConstInstruction>(Register);
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 	instruction->Operands.push_back(make_shared<InstructionOperand>(Value));
+	return nullptr;
 }
 
-void IntegerExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr IntegerExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
 	auto instruction = make_shared<MovWordConstInstruction>(Register);
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
 	instruction->Operands.push_back(make_shared<InstructionOperand>(Value));
+	return nullptr;
 }
 
-void FloatExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr FloatExpression::generateStep(ProgramCode_Ptr, ExpressionFrame&)
 {
 	//TODO: floats
 	//auto floatAddress = make_shared<FloatConstant>(Value);
@@ -1004,6 +1056,7 @@ void FloatExpression::generateCode(ProgramCode_Ptr code)
 	//code->AddInstruction(instruction);
 	//instruction->Operands.push_back(make_shared<InstructionOperand>(SI));
 	//instruction->Operands.push_back(floatAddress);
+	return nullptr;
 }
 
 void generate_false(ProgramCode_Ptr code, ConditionalNode* condNode)
@@ -1011,77 +1064,50 @@ void generate_false(ProgramCode_Ptr code, ConditionalNode* condNode)
 	auto instruction = make_shared<JMPInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(code->currentAddress));
-	instruction->Operands.push_back(condNode->falseJmpAddress);
+	instruction->Operands.push_back(code->FalseJmpAddress(condNode));
 }
 
-void TrueExpresion::generateCode(ProgramCode_Ptr code)
+Expression_Ptr TrueExpresion::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
-	if (findNotParent() != nullptr)
-		generate_false(code, findConditionalNodeParent());
+	if (code->InsideNot())
+		generate_false(code, code->ParentConditional());
+	return nullptr;
 }
 
-void FalseExpresion::generateCode(ProgramCode_Ptr code)
+Expression_Ptr FalseExpresion::generateStep(ProgramCode_Ptr code, ExpressionFrame&)
 {
-	if (findNotParent() == nullptr)
-		generate_false(code, findConditionalNodeParent());
+	if (!code->InsideNot())
+		generate_false(code, code->ParentConditional());
+	return nullptr;
 }
 
-void GroupedExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr GroupedExpression::generateStep(ProgramCode_Ptr, ExpressionFrame& frame)
 {
-	Expression->generateCode(code);
+	return frame.Stage++ == 0 ? Expression : nullptr;
 }
 
-void UnaryExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr UnaryExpression::generateStep(ProgramCode_Ptr, ExpressionFrame& frame)
 {
-	Expression->generateCode(code);
+	return nested(frame);
 }
 
-void SubExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr SubExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
-	UnaryExpression::generateCode(code);
+	Expression_Ptr next = nested(frame);
+	if (next != nullptr)
+		return next;
 	auto instruction = make_shared<NegInstruction>();
 	code->AddInstruction(instruction);
 	instruction->Operands.push_back(make_shared<InstructionOperand>(AX));
+	return nullptr;
 }
 
-void NotExpression::generateCode(ProgramCode_Ptr code)
+Expression_Ptr NotExpression::generateStep(ProgramCode_Ptr code, ExpressionFrame& frame)
 {
-	Expression->generateCode(code);
+	if (frame.Stage == 0)
+		code->NotsCount++;
+	Expression_Ptr next = nested(frame);
+	if (next == nullptr)
+		code->NotsCount--;
+	return next;
 }
-
-int main(int argc, char *argv[])
-{
-	if (argc != 2)
-	{
-		printf("Incorect number of arguments");
-		return -1;
-	}
-
-	fileName = argv[1];
-	vector<Lexem_ptr> lexems = lex_all(fileName);
-	//print_lexems(lexems);
-	Parser parser = Parser();
-	SyntaxTree_Ptr tree = parser.build_syntax_tree(lexems);
-	parser.print_tree(tree);
-
-	Scope_Ptr programScope = make_shared<Scope>();
-	tree->resolveNames(programScope);
-	if (errorsCount > 0)
-	{
-		printf("Program cannot be compiled. Errors counted: %d\n", errorsCount);
-		return -1;
-	}
-
-	ProgramCode_Ptr code = make_shared<ProgramCode>();
-	try {
-		tree->generateCode(code);
-	}
-	catch (exception)
-	{
-
-	}
-
-	code->Print();
-
-	return 0;
-}
\ No newline at end of file
@@ -89,7 +89,7 @@ protected:
 			return "si";
 		case 0b111:
 			return "di";
-		default:
+		default:
 			return "";
 		}
 	}
@@ -114,7 +114,7 @@ protected:
 			return "dh";
 		case 0b111:
 			return "bh";
-		default:
+		default:
 			return "";
 		}
 	}
@@ -139,7 +139,7 @@ protected:
 			return "bp";
 		case 0b111:
 			return "bx";
-		default:
+		default:
 			return "";
 		}
 	}
@@ -960,17 +960,32 @@ struct ProgramCode
 	std::vector<FloatConstant_Ptr> FloatConstants;
 	std::vector<StringConstant_Ptr> StringConstants;
 	int currentAddress = 0;
-	int currentRelativeAddress = 0;
-	int paramRelativeAddress = 2;
-	std::map<std::string, VariableDeclaration*> functionVariables;
-	std::map<std::string, Function*> functions;
+	std::unordered_map<Symbol, Function*> functions;
 	std::vector<char> RezervedFunctionsCode;
-
-	void AddFunction(std::string name, Function* function);
-	void AddParam(std::string, VariableDeclaration*);
-	void AddVariable(std::string, VariableDeclaration*, int additionalSpace);
+	//start addresses of the builtins by their index, the builtin functions themselves are shared by all programs
+	InstructionOperand_Ptr BuiltinAddresses[BuiltinsCount];
+	//jump targets of nodes, made when code first refers to them
+	std::unordered_map<ConditionalNode*, InstructionOperand_Ptr> falseJmpAddresses;
+	std::unordered_map<Node*, InstructionOperand_Ptr> startAddresses;
+	std::unordered_map<Node*, InstructionOperand_Ptr> endAddresses;
+	//conditional nodes being generated, the innermost one is the last
+	std::vector<ConditionalNode*> Conditionals;
+	//not expressions being generated
+	int NotsCount = 0;
+
+	ConditionalNode* ParentConditional() const { return Conditionals.empty() ? nullptr : Conditionals.back(); }
+	bool InsideNot() const { return NotsCount > 0; }
+
+	void AddFunction(Symbol name, Function* function);
+	//start of the function or builtin called by the name, set once its code is placed
+	InstructionOperand_Ptr FunctionAddress(Symbol name);
+	//the false address of a conditional can be replaced by another one, as or and and expressions do.
+	//A cycle ends at its false address, functions and cycles have start addresses and functions end addresses.
+	InstructionOperand_Ptr& FalseJmpAddress(ConditionalNode* node);
+	InstructionOperand_Ptr& StartAddress(Node* node);
+	InstructionOperand_Ptr& EndAddress(Node* node);
 	void AddInstruction(Instruction_Ptr);
-	void IncludeRezervedFunction(std::string name);
+	void IncludeRezervedFunction(Symbol name);
 
 	void Print();
 };
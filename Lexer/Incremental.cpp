@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "Incremental.h"
+#include <algorithm>
+
+using namespace std;
+
+void IncrementalSource::Reset(const string& text)
+{
+	Source.Text = text;
+	build();
+}
+
+void IncrementalSource::build()
+{
+	//every line is terminated by new line, as it is in loaded sources
+	if (!Source.Text.empty() && Source.Text.back() != '\n')
+		Source.Text.push_back('\n');
+
+	parts.clear();
+	int lexemsCount = 0;
+	parse_region(0, Source.Text.size(), 0, 0, parts, lexemsCount);
+}
+
+static void take_errors(vector<Diagnostic>& partErrors, const ErrorBuffer& errors, size_t& taken, size_t end)
+{
+	partErrors.insert(partErrors.end(), errors.Errors.begin() + taken, errors.Errors.begin() + end);
+	taken = end;
+}
+
+bool IncrementalSource::parse_region(size_t begin, size_t end, int firstLine, int firstLexem, vector<Part>& result, int& lexemsCount)
+{
+	//lines are counted from the region, so they stay right when lines before it are added or removed
+	int lineBase = firstLine > 0 ? firstLine - 1 : 0;
+	Lexer lexer(Source, begin, end, Symbols, firstLine > 0 ? 1 : 0);
+	LexemStore lexems;
+	vector<size_t> begins;
+	Lexem lexem;
+	while (lexer.next(lexem))
+	{
+		lexems.push(lexem);
+		if (lexem.Type != Error)
+			begins.push_back(lexem.Begin);
+	}
+
+	//next part has to start in start state, as it did when it was lexed
+	bool isLast = end == Source.Text.size();
+	if (!isLast && !lexer.in_start_state())
+		return false;
+	lexemsCount = (int)begins.size();
+
+	//errors are kept by the parts, they are reported by Tree()
+	ErrorBuffer errors;
+	size_t taken = 0;
+	size_t built = 0;
+	ErrorHandler::setBuffer(&errors);
+
+	LexemStream stream(lexems);
+	shared_ptr<NodeArena> arena = make_shared<NodeArena>();
+	Parser parser;
+	parser.start(stream, *arena);
+	while (!parser.at_end())
+	{
+		int first = parser.position();
+		int line = stream.line(first);
+		Part part;
+		part.Begin = begins[first];
+		part.FirstLine = lineBase + line;
+		part.FirstLexem = firstLexem + first;
+		part.LineBase = lineBase;
+
+		//lexical errors read by at_end are of the text between two functions and belong to the part before,
+		//except those found inside the first lexem of this part, which the lexer hands out before it
+		if (!result.empty())
+		{
+			size_t lineStart = part.Begin;
+			while (lineStart > 0 && Source.Text[lineStart - 1] != '\n')
+				lineStart--;
+			int column = (int)(part.Begin - lineStart) + 1;
+			size_t before = built;
+			while (before < errors.Errors.size() && (errors.Errors[before].Line < line
+				|| (errors.Errors[before].Line == line && errors.Errors[before].Column < column)))
+				before++;
+			take_errors(result.back().Errors, errors, taken, before);
+		}
+
+		part.Arena = arena;
+		part.Function = parser.build_function();
+		built = errors.Errors.size();
+
+		//the end of region is not the end of source, so parser must not look at it
+		if (!isLast && stream.pulled() > lexemsCount)
+		{
+			ErrorHandler::setBuffer(nullptr);
+			return false;
+		}
+		part.LastRead = firstLexem + stream.pulled() - 1;
+		result.push_back(move(part));
+	}
+	ErrorHandler::setBuffer(nullptr);
+
+	//text without functions can still have errors, they get a part so an edit there reports them again
+	if (result.empty() && !errors.Errors.empty())
+	{
+		Part part;
+		part.Begin = begin;
+		part.FirstLine = firstLine;
+		part.FirstLexem = firstLexem;
+		part.LastRead = firstLexem - 1;
+		part.LineBase = lineBase;
+		part.Function = nullptr;
+		result.push_back(move(part));
+	}
+	if (!result.empty())
+		take_errors(result.back().Errors, errors, taken, errors.Errors.size());
+	return true;
+}
+
+bool IncrementalSource::Edit(size_t offset, size_t removedLength, const string& insertedText)
+{
+	string& text = Source.Text;
+	if (offset + removedLength > text.size())
+		removedLength = offset > text.size() ? 0 : text.size() - offset;
+	if (offset > text.size())
+		offset = text.size();
+
+	size_t removedEnd = offset + removedLength;
+	ptrdiff_t delta = (ptrdiff_t)insertedText.size() - (ptrdiff_t)removedLength;
+	int lineDelta = (int)count(insertedText.begin(), insertedText.end(), '\n') - (int)count(text.begin() + offset, text.begin() + removedEnd, '\n');
+	text.replace(offset, removedLength, insertedText);
+
+	if (parts.empty() || text.empty() || text.back() != '\n')
+	{
+		build();
+		return false;
+	}
+
+	//edit on the border of two parts can change lexems of both
+	size_t first = 0;
+	while (first + 1 < parts.size() && parts[first + 1].Begin < offset)
+		first++;
+	size_t last = first;
+	while (last + 1 < parts.size() && parts[last + 1].Begin <= removedEnd)
+		last++;
+	for (size_t i = first; i-- > 0;)
+	{
+		if (parts[i].LastRead >= parts[first].FirstLexem)
+			first = i;
+	}
+	//columns of errors are counted from the line start, so parts starting on the line the edit ends on are parsed again
+	size_t lineEnd = text.find('\n', offset + insertedText.size());
+	while (last + 1 < parts.size() && parts[last + 1].Begin + delta <= lineEnd)
+		last++;
+
+	bool hasNext = last + 1 < parts.size();
+	size_t begin = first == 0 ? 0 : parts[first].Begin;
+	size_t end = hasNext ? parts[last + 1].Begin + delta : text.size();
+	int firstLine = first == 0 ? 0 : parts[first].FirstLine;
+	int firstLexem = first == 0 ? 0 : parts[first].FirstLexem;
+
+	vector<Part> edited;
+	int lexemsCount = 0;
+	if (!parse_region(begin, end, firstLine, firstLexem, edited, lexemsCount))
+	{
+		build();
+		return false;
+	}
+
+	int lexemsDelta = hasNext ? firstLexem + lexemsCount - parts[last + 1].FirstLexem : 0;
+	for (size_t i = last + 1; i < parts.size(); i++)
+	{
+		Part& part = parts[i];
+		part.Begin += delta;
+		part.FirstLine += lineDelta;
+		part.LineBase += lineDelta;
+		part.FirstLexem += lexemsDelta;
+		part.LastRead += lexemsDelta;
+	}
+
+	parts.erase(parts.begin() + first, parts.begin() + last + 1);
+	parts.insert(parts.begin() + first, make_move_iterator(edited.begin()), make_move_iterator(edited.end()));
+	return true;
+}
+
+SyntaxTree_Ptr IncrementalSource::Tree()
+{
+	SyntaxTree_Ptr tree = make_shared<SyntaxTree>();
+	for (Part& part : parts)
+	{
+		//reused nodes keep their lines, only the base they are counted from moved
+		if (part.Function != nullptr)
+		{
+			part.Function->LineBase = part.LineBase;
+			tree->functions.push_back(part.Function);
+		}
+		//cascades across parts are dropped here, as they are when the whole source is parsed
+		if (!part.Errors.empty())
+			ErrorHandler::flush(part.Errors, part.LineBase);
+	}
+	return tree;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "pch.h"
+#include "SourceBuffer.h"
+#include "SyntaxParser.h"
+
+//source of an editor buffer kept between compilations. An edit relexes and reparses only
+//the top level declarations it touches, syntax trees of the other functions are reused.
+struct IncrementalSource
+{
+	SourceBuffer Source;
+
+	//lexes and parses the whole text
+	void Reset(const std::string& text);
+	//replaces removedLength chars at offset, returns false when everything had to be parsed again
+	bool Edit(size_t offset, size_t removedLength, const std::string& insertedText);
+	//nodes of the tree stay owned by this source, their lines are counted from LineBase of their function.
+	//Errors of the whole source are reported again.
+	SyntaxTree_Ptr Tree();
+
+private:
+	//lexems taken by one Parser::build_function call, its text goes up to the next part
+	struct Part
+	{
+		size_t Begin;
+		int FirstLine;
+		int FirstLexem;
+		int LastRead; //parser can look at lexems of the next parts before it gives up
+		//lines of the nodes and errors are counted from the line before the text parsed together with the part,
+		//an edit before the part moves only LineBase
+		int LineBase;
+		Function_Ptr Function; //nullptr when no function was built, the part can still hold errors
+		std::shared_ptr<NodeArena> Arena; //shared by parts parsed together
+		//errors reported while the part was parsed and of the text up to the next part
+		std::vector<Diagnostic> Errors;
+	};
+	std::vector<Part> parts;
+
+	void build();
+	//false if [begin, end) could not be parsed without the rest of source
+	bool parse_region(size_t begin, size_t end, int firstLine, int firstLexem, std::vector<Part>& result, int& lexemsCount);
+};
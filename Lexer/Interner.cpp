@@ -0,0 +1,27 @@
+#include "pch.h"
+#include "Interner.h"
+#include "Builtins.h"
+
+using namespace std;
+
+Interner Symbols;
+
+Interner::Interner()
+{
+	Intern("main");
+	for (auto& builtin : Builtins)
+		Intern(builtin.Name);
+}
+
+Symbol Interner::Intern(std::string_view text)
+{
+	auto found = symbols.find(text);
+	if (found != symbols.end())
+		return found->second;
+
+	//deque never moves stored strings, so the views used as keys stay valid
+	texts.push_back(string(text));
+	Symbol symbol = (Symbol)texts.size() - 1;
+	symbols.insert(pair<string_view, Symbol>(texts.back(), symbol));
+	return symbol;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "pch.h"
+#include <deque>
+
+typedef int Symbol;
+
+//names used by the compiler itself, they are interned first so their symbols are constants.
+//Names of builtins follow, in the order of the Builtins table.
+enum KnownSymbol
+{
+	Symbol_main,
+	FirstBuiltinSymbol
+};
+
+struct Interner
+{
+	Interner();
+
+	Symbol Intern(std::string_view text);
+	const std::string& Text(Symbol symbol) const { return texts[symbol]; }
+	size_t Count() const { return texts.size(); }
+
+private:
+	std::deque<std::string> texts;
+	std::unordered_map<std::string_view, Symbol> symbols;
+};
+
+extern Interner Symbols;
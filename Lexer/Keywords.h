@@ -0,0 +1,95 @@
+#pragma once
+
+#include "pch.h"
+#include "Lexer.h"
+
+//keyword set of the language, new keywords only need an entry here
+struct Keyword
+{
+	std::string_view Text;
+	LexemType Type;
+};
+
+constexpr Keyword Keywords[] = {
+	{ "and", Op_and },
+	{ "or", Op_or },
+	{ "not", Op_not },
+	{ "true", Const_true },
+	{ "false", Const_false },
+	{ "bool", Bool_type },
+	{ "int", Integer_type },
+	{ "string", String_type },
+	{ "char", Char_type },
+	{ "float", Float_type },
+	{ "void", Void_type },
+	{ "if", If_keyword },
+	{ "else", Else_keyword },
+	{ "return", Return_keyword },
+	{ "while", While_keyword },
+	{ "break", Break_keyword },
+	{ "continue", Continue_keyword },
+	{ "print", Print_keyword },
+	{ "scan", Scan_keyword }
+};
+constexpr size_t KeywordsCount = sizeof(Keywords) / sizeof(Keywords[0]);
+static_assert(KeywordsCount == Scan_keyword - Op_and + 1, "Every keyword lexem type needs an entry in Keywords");
+
+constexpr size_t KeywordTableSize = 64;
+
+constexpr size_t keyword_hash(std::string_view word, size_t seed)
+{
+	size_t first = (unsigned char)word[0];
+	size_t last = (unsigned char)word[word.length() - 1];
+	return (first * seed + last * 31 + word.length()) % KeywordTableSize;
+}
+
+//searches for a seed which maps every keyword into a different slot
+constexpr size_t find_keyword_seed()
+{
+	for (size_t seed = 1; seed < 1024; seed++)
+	{
+		bool used[KeywordTableSize] = {};
+		bool collision = false;
+		for (size_t i = 0; i < KeywordsCount && !collision; i++)
+		{
+			size_t slot = keyword_hash(Keywords[i].Text, seed);
+			collision = used[slot];
+			used[slot] = true;
+		}
+		if (!collision)
+			return seed;
+	}
+
+	return 0;
+}
+constexpr size_t KeywordSeed = find_keyword_seed();
+static_assert(KeywordSeed != 0, "Keywords hash has collisions, increase KeywordTableSize");
+
+struct KeywordTable
+{
+	int Slots[KeywordTableSize];
+};
+
+constexpr KeywordTable build_keyword_table()
+{
+	KeywordTable table = {};
+	for (size_t i = 0; i < KeywordTableSize; i++)
+		table.Slots[i] = -1;
+	for (size_t i = 0; i < KeywordsCount; i++)
+		table.Slots[keyword_hash(Keywords[i].Text, KeywordSeed)] = (int)i;
+
+	return table;
+}
+constexpr KeywordTable KeywordSlots = build_keyword_table();
+
+inline LexemType find_keyword(std::string_view word)
+{
+	if (word.empty())
+		return Ident;
+
+	int index = KeywordSlots.Slots[keyword_hash(word, KeywordSeed)];
+	if (index >= 0 && Keywords[index].Text == word)
+		return Keywords[index].Type;
+
+	return Ident;
+}
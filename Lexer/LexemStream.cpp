@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "LexemStream.h"
+
+using namespace std;
+
+LexemStream::LexemStream(Lexer& lexer)
+{
+	this->lexer = &lexer;
+	resize_window(16);
+}
+
+LexemStream::LexemStream(const LexemStore& lexems)
+{
+	store = &lexems;
+	storeEnd = lexems.size();
+	resize_window(16);
+}
+
+LexemStream::LexemStream(const LexemStore& lexems, size_t begin, size_t end)
+{
+	store = &lexems;
+	storeIndex = begin;
+	storeEnd = end;
+	resize_window(16);
+	if (begin > 0)
+	{
+		Lexem before;
+		lexems.get(begin - 1, before);
+		first = this->end = -1;
+		place(before);
+	}
+}
+
+void LexemStream::resize_window(size_t capacity)
+{
+	Types.resize(capacity);
+	Lines.resize(capacity);
+	Values.resize(capacity);
+	Floats.resize(capacity);
+	Texts.resize(capacity);
+}
+
+void LexemStream::consume(int index)
+{
+	if (index > reader)
+		reader = index;
+}
+
+int LexemStream::mark(int index)
+{
+	marks.push_back(index);
+	return index;
+}
+
+void LexemStream::release(int mark)
+{
+	for (size_t i = marks.size(); i > 0; i--)
+	{
+		if (marks[i - 1] == mark)
+		{
+			marks.erase(marks.begin() + (i - 1));
+			return;
+		}
+	}
+}
+
+int LexemStream::rewind(int mark)
+{
+	release(mark);
+	reader = mark;
+	return mark;
+}
+
+void LexemStream::pull()
+{
+	if (end - first == (int)Types.size())
+	{
+		int keepFrom = reader - Lookbehind;
+		for (int mark : marks)
+		{
+			if (mark < keepFrom)
+				keepFrom = mark;
+		}
+		if (keepFrom > first)
+			first = keepFrom;
+		if (end - first == (int)Types.size())
+			grow();
+	}
+
+	//error lexems are reported here, parser never sees them
+	Lexem lexem;
+	bool hasLexem = next_lexem(lexem);
+	while (hasLexem && lexem.Type == Error)
+	{
+		report_lexem_error(lexem.Line, lexem.Error);
+		hasLexem = next_lexem(lexem);
+	}
+
+	//reading past the end of source gives EndOfFile, even if lexer could not finish with it
+	if (!hasLexem)
+	{
+		lexem.Type = EndOfFile;
+		lexem.Line = lastLine;
+		lexem.Value = 0;
+		lexem.FloatValue = 0;
+	}
+	lastLine = lexem.Line;
+	place(lexem);
+}
+
+void LexemStream::place(const Lexem& lexem)
+{
+	size_t index = end & (Types.size() - 1);
+	Types[index] = lexem.Type;
+	Lines[index] = lexem.Line;
+	Values[index] = lexem.Value;
+	Floats[index] = lexem.FloatValue;
+	Texts[index] = lexem.Text;
+	end++;
+}
+
+void LexemStream::grow()
+{
+	size_t capacity = Types.size();
+	size_t newCapacity = capacity * 2;
+	vector<LexemType> types(newCapacity);
+	vector<int> lines(newCapacity);
+	vector<int> values(newCapacity);
+	vector<double> floats(newCapacity);
+	vector<string_view> texts(newCapacity);
+	for (int i = first; i < end; i++)
+	{
+		size_t from = i & (capacity - 1);
+		size_t to = i & (newCapacity - 1);
+		types[to] = Types[from];
+		lines[to] = Lines[from];
+		values[to] = Values[from];
+		floats[to] = Floats[from];
+		texts[to] = Texts[from];
+	}
+	Types.swap(types);
+	Lines.swap(lines);
+	Values.swap(values);
+	Floats.swap(floats);
+	Texts.swap(texts);
+}
+
+bool LexemStream::next_lexem(Lexem& lexem)
+{
+	if (lexer != nullptr)
+		return lexer->next(lexem);
+	if (storeIndex >= storeEnd)
+		return false;
+
+	store->get(storeIndex++, lexem);
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "pch.h"
+#include "Lexer.h"
+#include <cassert>
+
+//window of lexems pulled from Lexer or LexemStore on demand, indexes are absolute lexem positions.
+//Lexems before the reader position are dropped unless they are pinned by a mark.
+struct LexemStream
+{
+	LexemStream(Lexer& lexer);
+	LexemStream(const LexemStore& lexems);
+	//only lexems [begin, end) of the store, EndOfFile follows them. The lexem before begin is at index -1,
+	//so lines can be looked up behind the first lexem as in a stream of the whole store.
+	LexemStream(const LexemStore& lexems, size_t begin, size_t end);
+
+	LexemType type(int index) { return Types[slot(index)]; }
+	int line(int index) { return Lines[slot(index)]; }
+	Symbol symbol(int index) { return Values[slot(index)]; }
+	int integer(int index) { return Values[slot(index)]; }
+	double floating(int index) { return Floats[slot(index)]; }
+	std::string_view text(int index) { return Texts[slot(index)]; }
+
+	//reader moved to index, older lexems can be dropped
+	void consume(int index);
+	//keeps lexems from index available until released or rewound to
+	int mark(int index);
+	void release(int mark);
+	int rewind(int mark);
+	//count of lexems read so far, the last read one included
+	int pulled() const { return end; }
+
+private:
+	//how many lexems before the reader stay available without a mark
+	static const int Lookbehind = 2;
+
+	Lexer* lexer = nullptr;
+	const LexemStore* store = nullptr;
+	size_t storeIndex = 0;
+	size_t storeEnd = 0;
+	std::vector<LexemType> Types;
+	std::vector<int> Lines;
+	std::vector<int> Values;
+	std::vector<double> Floats;
+	std::vector<std::string_view> Texts;
+	std::vector<int> marks;
+	int first = 0;
+	int end = 0;
+	int reader = 0;
+	int lastLine = 0;
+
+	size_t slot(int index)
+	{
+		//dropped lexems are gone, reading them needs a mark or more lookbehind
+		assert(index >= first);
+		while (index >= end)
+			pull();
+		return index & (Types.size() - 1);
+	}
+	void pull();
+	void place(const Lexem& lexem);
+	void grow();
+	void resize_window(size_t capacity);
+	bool next_lexem(Lexem& lexem);
+};
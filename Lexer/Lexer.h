@@ -2,6 +2,8 @@
 
 #include "../ErrorsHandler/ErrorHandler.h"
 #include "pch.h"
+#include "SourceBuffer.h"
+#include "Interner.h"
 
 enum LexemType
 {
@@ -49,22 +51,117 @@ enum LexemType
 	Float,
 	SQBracket_open,
 	SQBracket_close,
-	EndOfFile
+	EndOfFile,
+	Error
 };
 
+enum LexErrorCode
+{
+	UnexpectedChar,
+	UnknownEscape,
+	UnterminatedString,
+	EmptyChar,
+	UnterminatedChar,
+	ExpectedCommentStart,
+	UnterminatedComment,
+	UnexpectedConstantPrefix
+};
+
+//payload of Error lexem
+struct LexemError
+{
+	LexErrorCode Code;
+	int Column;
+	char Symbol; //char which caused the error
+};
+
+//single lexem handed out by Lexer
 struct Lexem
 {
-	LexemType type;
-	int lineNumber;
-	int value_i;
-	std::string value_s;
-	double value_f;
+	LexemType Type;
+	int Line;
+	int Value; //integer constant or Symbol of identifier
+	double FloatValue;
+	std::string_view Text; //points into SourceBuffer, escapes are not decoded
+	LexemError Error;
+	size_t Begin; //source offset of the first char, quotes included
+};
+
+//lexems are kept in parallel arrays, payload is an index into the literal tables or a Symbol for identifiers
+struct LexemStore
+{
+	std::vector<LexemType> Types;
+	std::vector<int> Lines;
+	std::vector<int> Values;
+
+	std::vector<int> Integers;
+	std::vector<double> Floats;
+	std::vector<std::string_view> Texts;
+	std::vector<LexemError> Errors;
+
+	size_t size() const { return Types.size(); }
+	LexemType type(size_t index) const { return Types[index]; }
+	int line(size_t index) const { return Lines[index]; }
+	Symbol symbol(size_t index) const { return Values[index]; }
+	int integer(size_t index) const { return Integers[Values[index]]; }
+	double floating(size_t index) const { return Floats[Values[index]]; }
+	std::string_view text(size_t index) const { return Values[index] < 0 ? std::string_view() : Texts[Values[index]]; }
+	const LexemError& error(size_t index) const { return Errors[Values[index]]; }
+
+	void push(const Lexem& lexem);
+	void get(size_t index, Lexem& lexem) const;
+};
+
+//lexes the source on demand, one lexem at a time
+struct Lexer
+{
+	Lexer(const SourceBuffer& source);
+	//lexes only [begin, end) of source, line numbers are counted from begin unless begin is known to be on firstLine
+	Lexer(const SourceBuffer& source, size_t begin, size_t end, Interner& interner, int firstLine = 0);
+
+	//returns false when the whole source range is lexed
+	bool next(Lexem& lexem);
+	//continues lexing up to newEnd once the current range is lexed
+	void extend(size_t newEnd);
+
+	bool in_start_state() const { return curentState == 0; }
+	int lines() const { return lineNumber; }
+
+private:
+	const char* sourceText;
+	size_t sourceLength;
+	size_t sourceSize;
+	Interner* interner;
+	size_t position = 0;
+	size_t charStart = 0;
+	size_t lexemStart = 0;
+	size_t tokenStart = 0;
+	size_t lineStart = 0;
+	bool isLineStart = true;
+	bool finished = false;
+	int lineNumber = 0;
+	int startLineNumber = 0;
+	int lexemsOffset = 0;
+	int curentState = 0;
+
+	//one char can finish two lexems
+	Lexem pending[2];
+	int pendingFirst = 0;
+	int pendingCount = 0;
+
+	void advance();
+	void lex_next(int nextChar);
+	void finish_lexem(LexemType type);
+	void finish_ident();
+	void add_error(LexErrorCode code, int nextChar);
 };
-typedef std::shared_ptr<Lexem> Lexem_ptr;
-
-std::vector<Lexem_ptr> lex_all(std::string fileName);
-void print_lexems(std::vector<Lexem_ptr> lexems);
-Lexem_ptr lex_next(char nextChar);
-Lexem_ptr finish_lexem(LexemType type, bool backtrack = false);
-Lexem_ptr finish_ident();
-void print_error(const char* errorText, const char* fileName);
\ No newline at end of file
+
+//sources of this size or bigger are split into chunks and lexed in parallel
+const size_t ParallelLexingSize = 1 << 20;
+
+void lex_all(const SourceBuffer& source, LexemStore& lexems);
+//contents of the char classes, transitions and keywords the lexer runs on, they change whenever lexing does
+std::vector<int> lexer_tables();
+void print_lexems(const LexemStore& lexems);
+std::string decode_literal(std::string_view text, LexemType type);
+void report_lexem_error(int line, const LexemError& error);
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "AstCache.h"
+#include "CodeGenerator.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	//Lexer [--ast-cache directory] [--max-errors N] file
+	string cacheDirectory;
+	int argument = 1;
+	for (; argument + 1 < argc; argument += 2)
+	{
+		string option = argv[argument];
+		if (option == "--ast-cache")
+			cacheDirectory = argv[argument + 1];
+		else if (option == "--max-errors")
+			ErrorHandler::setMaxErrors(atoi(argv[argument + 1]));
+		else
+			break;
+	}
+	if (argument != argc - 1)
+	{
+		printf("Incorect number of arguments");
+		return -1;
+	}
+
+	fileName = argv[argc - 1];
+	SourceBuffer source;
+	source.Load(fileName);
+	AstCache cache(cacheDirectory);
+	Parser parser = Parser();
+	SyntaxTree_Ptr tree;
+	if (!cacheDirectory.empty())
+		tree = cache.Load(source.Text);
+	if (tree == nullptr)
+	{
+		//big sources are lexed and parsed in parallel, others are lexed while parsing
+		Lexer lexer(source);
+		LexemStore lexemStore;
+		LexemStream lexems(lexer);
+		if (source.Text.size() >= ParallelLexingSize)
+		{
+			lex_all(source, lexemStore);
+			tree = parser.build_syntax_tree(lexemStore);
+		}
+		else
+			tree = parser.build_syntax_tree(lexems);
+		if (!cacheDirectory.empty() && errorsCount == 0)
+			cache.Save(source.Text, *tree);
+	}
+	ErrorHandler::printErrors();
+	parser.print_tree(tree, true);
+
+	Scope_Ptr programScope = make_shared<Scope>();
+	tree->resolveNames(programScope);
+	ErrorHandler::printErrors();
+	if (errorsCount > 0)
+	{
+		printf("Program cannot be compiled. Errors counted: %d\n", errorsCount);
+		return -1;
+	}
+
+	ProgramCode_Ptr code = make_shared<ProgramCode>();
+	try {
+		tree->generateCode(code);
+	}
+	catch (exception)
+	{
+
+	}
+
+	code->Print();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "NodeArena.h"
+
+using namespace std;
+
+void* NodeArena::allocate(size_t size, size_t alignment)
+{
+	size_t padding = (alignment - (size_t)current % alignment) % alignment;
+	if (current == nullptr || padding + size > left)
+	{
+		size_t blockSize = size + alignment > BlockSize ? size + alignment : BlockSize;
+		blocks.push_back(new char[blockSize]);
+		current = blocks.back();
+		left = blockSize;
+		padding = (alignment - (size_t)current % alignment) % alignment;
+	}
+
+	void* memory = current + padding;
+	current += padding + size;
+	left -= padding + size;
+	bytes += size;
+	return memory;
+}
+
+void NodeArena::Release()
+{
+	for (size_t i = destructors.size(); i-- > 0;)
+		destructors[i].Destroy(destructors[i].Object);
+	destructors.clear();
+
+	for (char* block : blocks)
+		delete[] block;
+	blocks.clear();
+	current = nullptr;
+	left = 0;
+	count = 0;
+	bytes = 0;
+}
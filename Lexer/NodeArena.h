@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pch.h"
+#include <new>
+#include <type_traits>
+
+//bump allocator for syntax tree nodes of one compilation, nodes are only released all at once.
+//Destructors are kept only for nodes owning memory of their own, like lists of statements.
+struct NodeArena
+{
+	NodeArena() {}
+	NodeArena(const NodeArena&) = delete;
+	NodeArena& operator=(const NodeArena&) = delete;
+	~NodeArena() { Release(); }
+
+	template<typename T> T* Make()
+	{
+		T* node = new (allocate(sizeof(T), alignof(T))) T();
+		if constexpr (!std::is_trivially_destructible<T>::value)
+			destructors.push_back({ node, [](void* object) { static_cast<T*>(object)->~T(); } });
+		count++;
+		return node;
+	}
+
+	void Release();
+	size_t Count() const { return count; }
+	size_t Bytes() const { return bytes; }
+
+private:
+	static const size_t BlockSize = 64 * 1024;
+
+	struct Destructor
+	{
+		void* Object;
+		void (*Destroy)(void*);
+	};
+
+	std::vector<char*> blocks;
+	std::vector<Destructor> destructors;
+	char* current = nullptr;
+	size_t left = 0;
+	size_t count = 0;
+	size_t bytes = 0;
+
+	void* allocate(size_t size, size_t alignment);
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "pch.h"
+#include "SyntaxParser.h"
+#include <algorithm>
+
+//passes over syntax trees dispatch on Node::Kind instead of virtual methods or type checks.
+//A visitor has visit(Node*) and overloads for the node types it handles, an overload for
+//a base type like BinaryExpression* handles all of its node types.
+template<typename Visitor> void visit_node(Node* node, Visitor& visitor)
+{
+	switch (node->Kind)
+	{
+	#define VISIT_NODE(CLASS) case Kind_ ## CLASS: visitor.visit(static_cast<CLASS*>(node)); break;
+	SYNTAX_NODES(VISIT_NODE)
+	#undef VISIT_NODE
+	default:
+		visitor.visit(node);
+		break;
+	}
+}
+
+template<typename Callback> void for_each_node(Node* node, Callback& function)
+{
+	if (node != nullptr)
+		function(node);
+}
+
+template<typename T, typename Callback> void for_each_node(const std::vector<T*>& nodes, Callback& function)
+{
+	for (T* node : nodes)
+		for_each_node(node, function);
+}
+
+//calls function for every child of the node in the order of the source
+template<typename Callback> void for_each_child(Node* node, Callback function)
+{
+	switch (node->Kind)
+	{
+	case Kind_Function:
+	{
+		auto result = static_cast<Function*>(node);
+		for_each_node(result->ReturnType, function);
+		for_each_node(result->Name, function);
+		for_each_node(result->Parameters, function);
+		for_each_node(result->Body, function);
+		break;
+	}
+	case Kind_ParamDef:
+		for_each_node(static_cast<ParamDef*>(node)->Type, function);
+		for_each_node(static_cast<ParamDef*>(node)->Name, function);
+		break;
+	case Kind_FunctionParamsDef:
+		for_each_node(static_cast<FunctionParamsDef*>(node)->Parameters, function);
+		break;
+	case Kind_BlockBody:
+		for_each_node(static_cast<BlockBody*>(node)->Statements, function);
+		break;
+	case Kind_AssignmentNode:
+		for_each_node(static_cast<AssignmentNode*>(node)->Expression, function);
+		break;
+	case Kind_AssignmentStatement:
+		for_each_node(static_cast<AssignmentStatement*>(node)->Variable, function);
+		for_each_node(static_cast<AssignmentStatement*>(node)->Assignment, function);
+		break;
+	case Kind_DeclarationStatement:
+	{
+		auto statement = static_cast<DeclarationStatement*>(node);
+		for_each_node(statement->Type, function);
+		for_each_node(statement->Variable, function);
+		for_each_node(statement->Size, function);
+		for_each_node(statement->Assignment, function);
+		break;
+	}
+	case Kind_FunctionCallStatement:
+		for_each_node(static_cast<FunctionCallStatement*>(node)->FunctionCall, function);
+		break;
+	case Kind_ReturnStatement:
+		for_each_node(static_cast<ReturnStatement*>(node)->ReturnValue, function);
+		break;
+	case Kind_PrintNode:
+		for_each_node(static_cast<PrintNode*>(node)->Expression, function);
+		break;
+	case Kind_PrintStatement:
+		for_each_node(static_cast<PrintStatement*>(node)->Prints, function);
+		break;
+	case Kind_ScanNode:
+		for_each_node(static_cast<ScanNode*>(node)->Identifier, function);
+		break;
+	case Kind_ScanStatement:
+		for_each_node(static_cast<ScanStatement*>(node)->Scans, function);
+		break;
+	case Kind_WhileStatement:
+		for_each_node(static_cast<WhileStatement*>(node)->Condition, function);
+		for_each_node(static_cast<WhileStatement*>(node)->Body, function);
+		break;
+	case Kind_IfStatement:
+		for_each_node(static_cast<IfStatement*>(node)->Condition, function);
+		for_each_node(static_cast<IfStatement*>(node)->Body, function);
+		for_each_node(static_cast<IfStatement*>(node)->Else, function);
+		break;
+	case Kind_ElseIf:
+		for_each_node(static_cast<ElseIf*>(node)->If, function);
+		break;
+	case Kind_Else:
+		for_each_node(static_cast<Else*>(node)->ElseBody, function);
+		break;
+	case Kind_MultiplicationExpression:
+	case Kind_AddExpression:
+	case Kind_CompExpression:
+	case Kind_OrExpression:
+	case Kind_AndExpression:
+		for_each_node(static_cast<BinaryExpression*>(node)->Left, function);
+		for_each_node(static_cast<BinaryExpression*>(node)->Right, function);
+		break;
+	case Kind_MemberAccessExpression:
+		for_each_node(static_cast<MemberAccessExpression*>(node)->AccessPosition, function);
+		break;
+	case Kind_FunctionCallExpression:
+		for_each_node(static_cast<FunctionCallExpression*>(node)->Name, function);
+		for_each_node(static_cast<FunctionCallExpression*>(node)->Parameters, function);
+		break;
+	case Kind_FunctionParams:
+		for_each_node(static_cast<FunctionParams*>(node)->Parameters, function);
+		break;
+	case Kind_Param:
+		for_each_node(static_cast<Param*>(node)->Expression, function);
+		break;
+	case Kind_GroupedExpression:
+		for_each_node(static_cast<GroupedExpression*>(node)->Expression, function);
+		break;
+	case Kind_SubExpression:
+	case Kind_NotExpression:
+		for_each_node(static_cast<UnaryExpression*>(node)->Expression, function);
+		break;
+	default:
+		break;
+	}
+}
+
+//visits the node and all nodes under it, every node before its children.
+//The walk keeps its own stack, so deep trees do not use the call stack.
+template<typename Visitor> void walk_tree(Node* root, Visitor& visitor)
+{
+	std::vector<Node*> stack;
+	if (root != nullptr)
+		stack.push_back(root);
+	while (!stack.empty())
+	{
+		Node* node = stack.back();
+		stack.pop_back();
+		visit_node(node, visitor);
+
+		size_t first = stack.size();
+		for_each_child(node, [&stack](Node* child) { stack.push_back(child); });
+		std::reverse(stack.begin() + first, stack.end());
+	}
+}
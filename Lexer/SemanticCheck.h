@@ -2,15 +2,56 @@
 
 #include "../Lexer/pch.h"
 #include "SyntaxParser.h"
+#include "Builtins.h"
 
+//names of all open scopes are in one table indexed by symbol, a name is bound to its innermost
+//declaration. Leaving a scope restores the bindings its declarations shadowed from the undo log.
 struct Scope
 {
-	static std::vector<Function_Ptr> RezervedFunctions;
-	std::shared_ptr<Scope> parentScope = nullptr;
+	//frozen scope with the names of functions, for scopes used by functions resolved in parallel
+	const Scope* Globals = nullptr;
+	//builtins found by the names, in the order of their first use
+	std::vector<Function_Ptr> UsedBuiltins;
+	//function and innermost cycle of the open scope, nested scopes keep them until they are set
+	Function* ParentFunction = nullptr;
+	WhileStatement* ParentCycle = nullptr;
 
-	void Add(std::string name, Node* node);
-	Node* Find(std::string name, int lineNumber);
+	void Add(Symbol name, Node* node);
+	Node* Find(Symbol name, int lineNumber);
+	void Enter();
+	void Leave();
+	//builtins used by the other scope are used after the ones used by this one
+	void Merge(const Scope& other);
 
 private:
-	std::map<std::string, Node*> variables;
-}; TO_PTR(Scope)
\ No newline at end of file
+	struct Binding
+	{
+		Node* Declaration = nullptr;
+		//scopes open when the name was declared
+		int Depth = 0;
+	};
+	struct Shadowed
+	{
+		Symbol Name;
+		Binding Previous;
+	};
+	struct Mark
+	{
+		size_t UndoSize;
+		Function* ParentFunction;
+		WhileStatement* ParentCycle;
+	};
+	std::vector<Binding> bindings;
+	std::vector<Shadowed> undoLog;
+	std::vector<Mark> marks;
+	bool builtinUsed[BuiltinsCount] = {};
+
+	Node* bound(Symbol name) const;
+	Function* useBuiltin(int index);
+}; TO_PTR(Scope)
+
+//bytes a variable of the type takes in a frame
+int GetTypeSize(ExpressionType type);
+
+//programs with this many functions or more have them resolved in parallel, after names of all functions are added
+const size_t ParallelResolvingSize = 128;
\ No newline at end of file
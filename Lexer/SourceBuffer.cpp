@@ -0,0 +1,29 @@
+#include "pch.h"
+#include "SourceBuffer.h"
+#include <fstream>
+
+using namespace std;
+
+bool SourceBuffer::Load(const std::string& fileName)
+{
+	Text.clear();
+	ifstream file(fileName, ios::binary);
+	if (!file)
+		return false;
+
+	file.seekg(0, ios::end);
+	streamoff size = file.tellg();
+	file.seekg(0, ios::beg);
+	if (size > 0)
+	{
+		Text.resize((size_t)size);
+		file.read(&Text[0], size);
+		Text.resize((size_t)file.gcount());
+	}
+
+	//every line is terminated by new line, as it was with getline
+	if (!Text.empty() && Text.back() != '\n')
+		Text.push_back('\n');
+
+	return true;
+}
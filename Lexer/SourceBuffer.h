@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pch.h"
+
+struct SourceBuffer
+{
+	std::string Text;
+
+	bool Load(const std::string& fileName);
+};
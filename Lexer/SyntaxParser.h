@@ -1,14 +1,18 @@
 #pragma once
 #include "Lexer.h"
+#include "LexemStream.h"
+#include "NodeArena.h"
 #include "pch.h"
 
 #define TO_PTR(CLASS) typedef std::shared_ptr<CLASS> ## CLASS ## _Ptr;
+//syntax tree nodes live in NodeArena of their tree
+#define NODE_PTR(CLASS) typedef CLASS* CLASS ## _Ptr;
 
 struct Scope; TO_PTR(Scope)
 struct ProgramCode; TO_PTR(ProgramCode)
 struct InstructionOperand
 {
-	int value;
+	int value = 0;
 	InstructionOperand(){}
 	InstructionOperand(int Value)
 	{
@@ -17,8 +21,6 @@ struct InstructionOperand
 }; TO_PTR(InstructionOperand)
 struct WhileStatement;
 struct Function;
-struct ConditionalNode;
-struct NotExpression;
 
 enum ExpressionType
 {
@@ -35,78 +37,50 @@ enum ExpressionType
 	VoidType	 
 };
 
+//every node type the parser makes
+#define SYNTAX_NODES(NODE) \
+	NODE(Function) NODE(Identifier) \
+	NODE(BoolKeyword) NODE(IntegerKeyword) NODE(FloatKeyword) NODE(StringKeyword) NODE(CharKeyword) NODE(VoidKeyword) \
+	NODE(ParamDef) NODE(FunctionParamsDef) NODE(BlockBody) NODE(EmptyStatement) NODE(AssignmentNode) \
+	NODE(AssignmentStatement) NODE(DeclarationStatement) NODE(FunctionCallStatement) NODE(ReturnStatement) \
+	NODE(PrintNode) NODE(PrintStatement) NODE(ScanNode) NODE(ScanStatement) NODE(BreakStatement) NODE(ContinueStatement) \
+	NODE(WhileStatement) NODE(IfStatement) NODE(ElseIf) NODE(Else) \
+	NODE(MultiplicationExpression) NODE(AddExpression) NODE(CompExpression) NODE(OrExpression) NODE(AndExpression) \
+	NODE(IdentifierExpression) NODE(MemberAccessExpression) NODE(FunctionCallExpression) NODE(FunctionParams) NODE(Param) \
+	NODE(StringExpression) NODE(CharExpression) NODE(IntegerExpression) NODE(FloatExpression) \
+	NODE(TrueExpresion) NODE(FalseExpresion) NODE(GroupedExpression) NODE(SubExpression) NODE(NotExpression)
+
+#define NODE_KIND(CLASS) Kind_ ## CLASS,
+enum NodeKind : unsigned char
+{
+	NoKind,
+	SYNTAX_NODES(NODE_KIND)
+	NodeKindsCount
+};
+#undef NODE_KIND
+
+//names of the node kinds, the tree print shows them
+extern const char* const NodeKindNames[NodeKindsCount];
+
 struct Node
 {
 	int LineNumber = 0;
+	//set by create_node, switches on it replace type checks
+	NodeKind Kind = NoKind;
 
-	std::shared_ptr<Node> parent;
+	Node* parent = nullptr;
 
 	virtual void resolveNames(Scope_Ptr scope);
 	virtual void generateCode(ProgramCode_Ptr code);
-	virtual void print(int level)
-	{
-		printf("%s%s\n", std::string(level*2, ' ').c_str(), std::string(typeid(*this).name()).substr(6).c_str());
-	}
-
-	WhileStatement* findCycleParent();
-
-	Function* findFunctionParent();
-
-	ConditionalNode* findConditionalNodeParent();
-	NotExpression* findNotParent();
 };
-TO_PTR(Node)
+NODE_PTR(Node)
 
-struct Token : Node {}; TO_PTR(Token)
+struct Token : Node {}; NODE_PTR(Token)
 
 struct Identifier : Token 
 {
-	std::string Value;
-
-	void print(int level) override
-	{
-		Token::print(level);
-		printf("%sValue: %s\n", std::string((level + 1) * 2, ' ').c_str(), Value.c_str());
-	}
-}; TO_PTR(Identifier)
-
-struct BlockStart : Token {}; TO_PTR(BlockStart)
-struct BlockEnd : Token {}; TO_PTR(BlockEnd)
-struct StatementEnd : Token {}; TO_PTR(StatementEnd)
-struct SeperatorToken : Token {}; TO_PTR(SeperatorToken)
-struct OpenParan : Token {}; TO_PTR(OpenParan)
-struct CloseParan : Token {}; TO_PTR(CloseParan)
-struct SQBracketOpen : Token {}; TO_PTR(SQBracketOpen)
-struct SQBracketClose : Token {}; TO_PTR(SQBracketClose)
-struct WhileKeyword : Token {}; TO_PTR(WhileKeyword)
-struct IfKeyword : Token {}; TO_PTR(IfKeyword)
-struct ElseKeyword : Token {}; TO_PTR(ElseKeyword)
-struct ReturnKeyword : Token {}; TO_PTR(ReturnKeyword)
-struct ScanKeyword : Token {}; TO_PTR(ScanKeyword)
-struct PrintKeyword : Token {}; TO_PTR(PrintKeyword)
-struct BreakKeyword : Token {}; TO_PTR(BreakKeyword)
-struct ContinueKeyword : Token {}; TO_PTR(ContinueKeyword)
-struct TrueKeyword : Token {}; TO_PTR(TrueKeyword)
-struct FalseKeyword : Token {}; TO_PTR(FalseKeyword)
-
-struct OpPrint : Token {}; TO_PTR(OpPrint)
-struct OpScan : Token {}; TO_PTR(OpScan)
-struct OpAssign : Token {}; TO_PTR(OpAssign)
-struct OpMinus : Token {}; TO_PTR(OpMinus)
-struct OpNot : Token {}; TO_PTR(OpNot)
-struct OpAnd : Token {}; TO_PTR(OpAnd)
-struct OpOr : Token {}; TO_PTR(OpOr)
-
-struct OpComp : Token {}; TO_PTR(OpComp)
-struct OpLess : OpComp {}; TO_PTR(OpLess)
-struct OpMore : OpComp {}; TO_PTR(OpMore)
-struct OpMoreEq : OpComp {}; TO_PTR(OpMoreEq)
-struct OpLessEq : OpComp {}; TO_PTR(OpLessEq)
-struct OpEq : OpComp {}; TO_PTR(OpEq)
-struct OpNotEq : OpComp {}; TO_PTR(OpNotEq)
-
-struct OpMult : Token {}; TO_PTR(OpMult)
-struct OpAdd : Token {}; TO_PTR(OpAdd)
+	Symbol Value;
+}; NODE_PTR(Identifier)
 
 struct TypeKeyword : Token 
 {
@@ -119,7 +93,7 @@ struct TypeKeyword : Token
 		return 2;
 	}
 	bool IsPointer;
-}; TO_PTR(TypeKeyword)
+}; NODE_PTR(TypeKeyword)
 struct BoolKeyword : TypeKeyword 
 {
 	ExpressionType getType() override
@@ -130,7 +104,7 @@ struct BoolKeyword : TypeKeyword
 	{
 		return 1;
 	}
-}; TO_PTR(BoolKeyword)
+}; NODE_PTR(BoolKeyword)
 struct IntegerKeyword : TypeKeyword 
 {
 	ExpressionType getType() override
@@ -141,7 +115,7 @@ struct IntegerKeyword : TypeKeyword
 	{
 		return 2;
 	}
-}; TO_PTR(IntegerKeyword)
+}; NODE_PTR(IntegerKeyword)
 struct FloatKeyword : TypeKeyword 
 {
 	ExpressionType getType() override
@@ -152,7 +126,7 @@ struct FloatKeyword : TypeKeyword
 	{
 		return 4;
 	}
-}; TO_PTR(FloatKeyword)
+}; NODE_PTR(FloatKeyword)
 struct StringKeyword : TypeKeyword 
 {
 	int Size;
@@ -164,7 +138,7 @@ struct StringKeyword : TypeKeyword
 	{
 		return Size;
 	}
-}; TO_PTR(StringKeyword)
+}; NODE_PTR(StringKeyword)
 struct CharKeyword : TypeKeyword 
 {
 	ExpressionType getType() override
@@ -175,827 +149,478 @@ struct CharKeyword : TypeKeyword
 	{
 		return 1;
 	}
-}; TO_PTR(CharKeyword)
+}; NODE_PTR(CharKeyword)
 struct VoidKeyword : TypeKeyword 
 {
 	ExpressionType getType() override
 	{
 		return VoidType;
 	}
-}; TO_PTR(VoidKeyword)
+}; NODE_PTR(VoidKeyword)
 
 struct VariableDeclaration
 {
-	TypeKeyword_Ptr Type;
+	TypeKeyword_Ptr Type = nullptr;
 	int relativeAddress;
-}; TO_PTR(VariableDeclaration)
+}; NODE_PTR(VariableDeclaration)
+
+//nodes whose conditions jump to a false address, ProgramCode keeps the address while code is generated
+struct ConditionalNode {};
+
+struct Expression;
 
-struct ConditionalNode
+//state of an expression in the loops of Expression, which keep the nested expressions on
+//their own stack. A step of the expression returns the nested expression to do next
+//or nullptr when the expression is done, Stage counts the steps done so far.
+struct ExpressionFrame
 {
-	InstructionOperand_Ptr falseJmpAddress = std::make_shared<InstructionOperand>();
+	Expression* Owner;
+	int Stage = 0;
+	ExpressionType ChildResult = Unknown;
+	ExpressionType Result = Unknown;
+	Function* Callee = nullptr;
+	ConditionalNode* CondParent = nullptr;
+	InstructionOperand_Ptr Operand = nullptr;
+	std::vector<ConditionalNode*> Conditionals;
+	int NotsCount = 0;
+
+	ExpressionFrame(Expression* owner) : Owner(owner) {}
 };
 
 struct Expression : Node {
 	ExpressionType Type;
 	void resolveNames(Scope_Ptr) override {}
-	virtual ExpressionType resolveType(Scope_Ptr);
-}; TO_PTR(Expression)
+	//the loops, expressions implement the steps. The steps of resolveType are picked by the kind
+	//of the expression, each expression type has a resolveStep.
+	ExpressionType resolveType(Scope_Ptr scope);
+	void generateCode(ProgramCode_Ptr code) override;
+
+	virtual Expression* generateStep(ProgramCode_Ptr code, ExpressionFrame& frame);
+}; NODE_PTR(Expression)
 
 struct Param : Node
 {
-	Expression_Ptr Expression;
-	SeperatorToken_Ptr Seperator;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Expression != nullptr)
-			Expression->print(level);
-		if (Seperator != nullptr)
-			Seperator->print(level);
-	}
-}; TO_PTR(Param)
+	Expression_Ptr Expression = nullptr;
+	bool HasSeperator = false;
+}; NODE_PTR(Param)
 
 struct FunctionParams : Node
 {
-	OpenParan_Ptr ListStartToken;
 	std::vector<Param_Ptr> Parameters;
-	CloseParan_Ptr ListEndToken;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (ListStartToken != nullptr)
-			ListStartToken->print(level);
-		for (Param_Ptr param : Parameters)
-		{
-			param->print(level);
-		}
-		if (ListEndToken != nullptr)
-			ListEndToken->print(level);
-	}
+	bool HasListEnd = false;
+}; NODE_PTR(FunctionParams)
 
-}; TO_PTR(FunctionParams)
+const char* operator_token_name(LexemType type);
 
 struct BinaryExpression : Expression
 {
-	Expression_Ptr Left;
-	Expression_Ptr Right;
+	Expression_Ptr Left = nullptr;
+	Expression_Ptr Right = nullptr;
+	LexemType Operator = Op_add;
+	int OperatorLine = 0;
 
-	void print(int level) override
-	{
-		Expression::print(level);
-		level++;
-		if (Left != nullptr)
-			Left->print(level);
-		if (Right != nullptr)
-			Right->print(level);
-	}
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(BinaryExpression)
+	//operands of the expression which are not missing, one per step
+	Expression_Ptr next_operand(ExpressionFrame& frame);
+	//checkTypes of the expression type has the rules of the operator for resolved operand types
+	//value of Left is pushed while Right is evaluated, then it is in AX and Right in BX
+	Expression_Ptr generateOperands(ProgramCode_Ptr, ExpressionFrame& frame);
+}; NODE_PTR(BinaryExpression)
 
 struct MultiplicationExpression : BinaryExpression
 {
-	OpMult_Ptr Operator;
-	void print(int level) override
-	{
-		BinaryExpression::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(MultiplicationExpression)
+	ExpressionType checkTypes(ExpressionType leftType, ExpressionType rightType);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(MultiplicationExpression)
 
 struct AddExpression : BinaryExpression
 {
-	OpAdd_Ptr Operator;
-
-	void print(int level) override
-	{
-		BinaryExpression::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(AddExpression)
+	ExpressionType checkTypes(ExpressionType leftType, ExpressionType rightType);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(AddExpression)
 
 struct CompExpression : BinaryExpression, ConditionalNode
 {
-	CompExpression()
-	{
-		falseJmpAddress->value = -1;
-	}
-	OpComp_Ptr Operator;
-
-	void print(int level) override
-	{
-		BinaryExpression::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(CompExpression)
+	ExpressionType checkTypes(ExpressionType leftType, ExpressionType rightType);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(CompExpression)
 
 struct OrExpression : BinaryExpression, ConditionalNode
 {
-	OrExpression()
-	{
-		falseJmpAddress->value = 1;
-	}
-	OpOr_Ptr Operator;
-
-	void print(int level) override
-	{
-		BinaryExpression::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(OrExpression)
+	ExpressionType checkTypes(ExpressionType leftType, ExpressionType rightType);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(OrExpression)
 
 struct AndExpression : BinaryExpression, ConditionalNode
 {
-	AndExpression()
-	{
-		falseJmpAddress->value = 0x100;
-	}
-
-	OpAnd_Ptr Operator;
-
-	void print(int level) override
-	{
-		BinaryExpression::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(AndExpression)
+	ExpressionType checkTypes(ExpressionType leftType, ExpressionType rightType);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(AndExpression)
 
 struct IdentifierExpression : Expression
 {
-	std::string Value;
+	Symbol Value;
 
-	void print(int level) override
-	{
-		Expression::print(level);
-		printf("%sValue: %s\n", std::string((level+1)*2, ' ').c_str(), Value.c_str());
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
 	virtual void setData(ProgramCode_Ptr code, ExpressionType type);
+	//moves the value to AX after setData
+	void loadValue(ProgramCode_Ptr code);
+
+	//variable found by the semantic check and its slot in the frame, relative to BP
+	VariableDeclaration* Declaration = nullptr;
+	int Slot = 0;
 
 	int AccessRegister;
-	InstructionOperand_Ptr Offset;
+	InstructionOperand_Ptr Offset = nullptr;
 	int AccessMod;
 };
-TO_PTR(IdentifierExpression)
+NODE_PTR(IdentifierExpression)
 
 struct MemberAccessExpression : IdentifierExpression
 {
-	Expression_Ptr AccessPosition; //TODO: make sure it is it
+	Expression_Ptr AccessPosition = nullptr; //TODO: make sure it is it
 
-	void print(int level) override
-	{
-		IdentifierExpression::print(level);
-		AccessPosition->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
 	void setData(ProgramCode_Ptr code, ExpressionType type) override;
-}; TO_PTR(MemberAccessExpression)
+	//setData is split around the code of AccessPosition
+	void enterAccess(ProgramCode_Ptr code, ExpressionFrame& frame);
+	void leaveAccess(ProgramCode_Ptr code, ExpressionType type, ExpressionFrame& frame);
+}; NODE_PTR(MemberAccessExpression)
 
 struct FunctionCallExpression : Expression
 {
-	IdentifierExpression_Ptr Name;
-	FunctionParams_Ptr Parameters;
-
-	void print(int level) override
-	{
-		Expression::print(level);
-		level++;
-		if (Name != nullptr)
-			Name->print(level);
-		if (Parameters != nullptr)
-			Parameters->print(level);
-	}
+	IdentifierExpression_Ptr Name = nullptr;
+	FunctionParams_Ptr Parameters = nullptr;
 
 	void resolveNames(Scope_Ptr) override;
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(FunctionCallExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(FunctionCallExpression)
 
 struct StringExpression : Expression
 {
 	std::string Value;
 
-	void print(int level) override
-	{
-		Expression::print(level);
-		printf("%sValue: %s\n", std::string((level + 1) * 2, ' ').c_str(), Value.c_str());
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(StringExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(StringExpression)
 
 struct CharExpression : Expression
 {
 	char Value;
-	void print(int level) override
-	{
-		Expression::print(level);
-		printf("%sValue: %c\n", std::string((level + 1) * 2, ' ').c_str(), Value);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(CharExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(CharExpression)
 
 struct IntegerExpression : Expression
 {
 	int Value;
-	void print(int level) override
-	{
-		Expression::print(level);
-		printf("%sValue: %d\n", std::string((level + 1) * 2, ' ').c_str(), Value);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(IntegerExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(IntegerExpression)
 
 struct FloatExpression : Expression
 {
 	double Value;
-	void print(int level) override
-	{
-		Expression::print(level);
-		printf("%sValue: %f\n", std::string((level + 1) * 2, ' ').c_str(), Value);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(FloatExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(FloatExpression)
 
 struct BoolExpression : Expression
 {
-	ExpressionType resolveType(Scope_Ptr) override;
-}; TO_PTR(BoolExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+}; NODE_PTR(BoolExpression)
 
 struct TrueExpresion : BoolExpression
 {
-	TrueKeyword_Ptr Keyword;
-
-	void print(int level) override
-	{
-		Expression::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-	}
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(TrueExpresion)
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(TrueExpresion)
 
 struct FalseExpresion : BoolExpression
 {
-	FalseKeyword_Ptr Keyword;
-
-	void print(int level) override
-	{
-		Expression::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-	}
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(FalseExpresion)
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(FalseExpresion)
 
 struct GroupedExpression : Expression
 {
-	OpenParan_Ptr GroupStart;
-	Expression_Ptr Expression;
-	CloseParan_Ptr GroupFinish;
+	Expression_Ptr Expression = nullptr;
 
-	void print(int level) override
-	{
-		Expression::print(level);
-		level++;
-		if (GroupStart != nullptr)
-			GroupStart->print(level);
-		if (Expression != nullptr)
-			Expression->print(level);
-		if (GroupFinish != nullptr)
-			GroupFinish->print(level);
-	}
 	void resolveNames(Scope_Ptr) override;
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(GroupedExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(GroupedExpression)
 
 struct UnaryExpression : Expression
 {
-	Expression_Ptr Expression;
+	Expression_Ptr Expression = nullptr;
 
-	void print(int level) override
+	//the nested expression, once
+	Expression_Ptr nested(ExpressionFrame& frame)
 	{
-		Expression::print(level);
-		level++;
-		if (Expression != nullptr)
-			Expression->print(level);
+		return frame.Stage++ == 0 ? Expression : nullptr;
 	}
 	void resolveNames(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(UnaryExpression)
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(UnaryExpression)
 
 struct SubExpression : UnaryExpression
 {
-	OpMinus_Ptr Prefix;
-
-	void print(int level) override
-	{
-		UnaryExpression::print(level);
-		level++;
-		if (Prefix != nullptr)
-			Prefix->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(SubExpression)
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(SubExpression)
 
 struct NotExpression : UnaryExpression
 {
-	OpNot_Ptr Prefix;
+	Expression_Ptr resolveStep(Scope_Ptr, ExpressionFrame& frame);
+	Expression_Ptr generateStep(ProgramCode_Ptr, ExpressionFrame& frame) override;
+}; NODE_PTR(NotExpression)
 
-	void print(int level) override
-	{
-		UnaryExpression::print(level);
-		level++;
-		if (Prefix != nullptr)
-			Prefix->print(level);
-	}
-	ExpressionType resolveType(Scope_Ptr) override;
-	void generateCode(ProgramCode_Ptr) override;
-}; TO_PTR(NotExpression)
-
-struct Body : Node {}; TO_PTR(Body)
+struct Body : Node {}; NODE_PTR(Body)
 
-struct Statement : Body {}; TO_PTR(Statement)
+struct Statement : Body {}; NODE_PTR(Statement)
 
 struct BlockBody : Body
 {
-	BlockStart_Ptr Start;
 	std::vector<Statement_Ptr> Statements;
-	BlockEnd_Ptr End;
-
-	void print(int level) override
-	{
-		Body::print(level);
-		level++;
-		Start->print(level);
-		for (Statement_Ptr stmt : Statements)
-		{
-			stmt->print(level);
-		}
-		if (End != nullptr)
-			End->print(level);
-	}
+	bool HasEnd = false;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
 };
-TO_PTR(BlockBody)
+NODE_PTR(BlockBody)
 
 struct EmptyStatement : Statement
 {
-	StatementEnd_Ptr EndToken;
-	void print(int level) override
-	{
-		Statement::print(level);
-		level++;
-		if(EndToken != nullptr)
-			EndToken->print(level);;
-	}
+	bool HasEndToken = false;
 
 	void resolveNames(Scope_Ptr scope) override {}
 	void generateCode(ProgramCode_Ptr code) override {}
-}; TO_PTR(EmptyStatement)
+}; NODE_PTR(EmptyStatement)
 
 struct AssignmentNode : Node
 {
-	OpAssign_Ptr Operator;
-	Expression_Ptr Expression;
+	Expression_Ptr Expression = nullptr;
 
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-		if (Expression != nullptr)
-			Expression->print(level);
-	}
 	void CheckIsType(ExpressionType, Scope_Ptr);
-}; TO_PTR(AssignmentNode)
+}; NODE_PTR(AssignmentNode)
 
 struct AssignmentStatement : EmptyStatement, ConditionalNode
 {
-	AssignmentStatement()
-	{
-		falseJmpAddress->value = 0x1000;
-	}
-
-	IdentifierExpression_Ptr Variable;
-	AssignmentNode_Ptr Assignment;
-
-	void print(int level) override
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (Variable != nullptr)
-			Variable->print(level);
-		if (Assignment != nullptr)
-			Assignment->print(level);
-	}
+	IdentifierExpression_Ptr Variable = nullptr;
+	AssignmentNode_Ptr Assignment = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(AssignmentStatement)
+}; NODE_PTR(AssignmentStatement)
 
 struct DeclarationStatement : EmptyStatement, VariableDeclaration, ConditionalNode
 {
-	DeclarationStatement()
-	{
-		falseJmpAddress->value = 0x111;
-	}
-
-	Identifier_Ptr Variable;
-	AssignmentNode_Ptr Assignment;
-	IntegerExpression_Ptr Size;
-
-	void print(int level) override
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (Type != nullptr)
-			Type->print(level);
-		if (Variable != nullptr)
-			Variable->print(level);
-		if (Assignment != nullptr)
-			Assignment->print(level);
-	}
+	Identifier_Ptr Variable = nullptr;
+	AssignmentNode_Ptr Assignment = nullptr;
+	IntegerExpression_Ptr Size = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(DeclarationStatement)
+}; NODE_PTR(DeclarationStatement)
 
 struct PointerDeclarationStatement : DeclarationStatement
 {
-	Expression_Ptr Size;
-	TypeKeyword_Ptr ItemType;
+	Expression_Ptr Size = nullptr;
+	TypeKeyword_Ptr ItemType = nullptr;
 };
 
 struct FunctionCallStatement : EmptyStatement
 {
-	FunctionCallExpression_Ptr FunctionCall;
-	void print(int level) override
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (FunctionCall != nullptr)
-			FunctionCall->print(level);
-	}
+	FunctionCallExpression_Ptr FunctionCall = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(FunctionCallStatement)
+}; NODE_PTR(FunctionCallStatement)
 
 struct ReturnStatement : EmptyStatement, ConditionalNode
 {
-	ReturnStatement()
-	{
-		falseJmpAddress->value = 0x11110;
-	}
-
-	ReturnKeyword_Ptr Keyword;
-	Expression_Ptr ReturnValue;
-
-	void print(int level)
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-		if (ReturnValue != nullptr)
-			ReturnValue->print(level);
-	}
+	Expression_Ptr ReturnValue = nullptr;
+	//found by semantic check
+	Function* ParentFunction = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(ReturnStatement)
+}; NODE_PTR(ReturnStatement)
 
 struct PrintNode : Node
 {
-	OpPrint_Ptr Operator;
-	Expression_Ptr Expression;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-		if (Expression != nullptr)
-			Expression->print(level);
-	}
-}; TO_PTR(PrintNode)
+	Expression_Ptr Expression = nullptr;
+}; NODE_PTR(PrintNode)
 
 struct PrintStatement : EmptyStatement
 {
-	PrintKeyword_Ptr Keyword;
 	std::vector<PrintNode_Ptr> Prints;
 
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-		for (PrintNode_Ptr print : Prints)
-		{
-			print->print(level);
-		}
-	}
-
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(PrintStatement)
+}; NODE_PTR(PrintStatement)
 
 struct ScanNode : Node
 {
-	OpScan_Ptr Operator;
-	IdentifierExpression_Ptr Identifier;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Operator != nullptr)
-			Operator->print(level);
-		if (Identifier != nullptr)
-			Identifier->print(level);
-	}
-}; TO_PTR(ScanNode)
+	IdentifierExpression_Ptr Identifier = nullptr;
+}; NODE_PTR(ScanNode)
 
 struct ScanStatement : EmptyStatement
 {
-	ScanKeyword_Ptr Keyword;
 	std::vector<ScanNode_Ptr> Scans;
 
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-		for (ScanNode_Ptr scan : Scans)
-		{
-			scan->print(level);
-		}
-	}
-
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(ScanStatement)
+}; NODE_PTR(ScanStatement)
 
 struct BreakStatement : EmptyStatement
 {
-	BreakKeyword_Ptr Keyword;
+	//found by semantic check
+	WhileStatement* ParentCycle = nullptr;
 
-	void print(int level) override
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-	}
 	void resolveNames(Scope_Ptr) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(BreakStatement)
+}; NODE_PTR(BreakStatement)
 
 struct ContinueStatement : EmptyStatement
 {
-	ContinueKeyword_Ptr Keyword;
-
-	void print(int level) override
-	{
-		EmptyStatement::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-	}
+	//found by semantic check
+	WhileStatement* ParentCycle = nullptr;
 
 	void resolveNames(Scope_Ptr) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(ContinueStatement)
+}; NODE_PTR(ContinueStatement)
 
 struct  WhileStatement : Statement, ConditionalNode
 {
-	WhileStatement()
-	{
-		falseJmpAddress->value = 0x11001;
-	}
-
-	WhileKeyword_Ptr Keyword;
-	Expression_Ptr Condition;
-	Body_Ptr Body;
-	InstructionOperand_Ptr statementStartAddress = std::make_shared<InstructionOperand>();
-	InstructionOperand_Ptr statementEndAddress = falseJmpAddress;
-
-	void print(int level) override
-	{
-		Statement::print(level);
-		level++;
-		if (Keyword != nullptr)
-			Keyword->print(level);
-		if (Condition != nullptr)
-			Condition->print(level);
-		if (Body != nullptr)
-			Body->print(level);
-	}
+	Expression_Ptr Condition = nullptr;
+	Body_Ptr Body = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(WhileStatement)
-
-struct ElseNode : Node 
-{
-	ElseKeyword_Ptr ElseKeyword;
+}; NODE_PTR(WhileStatement)
 
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (ElseKeyword != nullptr)
-			ElseKeyword->print(level);
-	}
-}; TO_PTR(ElseNode)
+struct ElseNode : Node {}; NODE_PTR(ElseNode)
 
 struct IfStatement : Statement, ConditionalNode
 {
-	IfStatement()
-	{
-		falseJmpAddress->value = 0x11110000;
-	}
-
-	IfKeyword_Ptr IfKeyword;
-	Expression_Ptr Condition;
-	Body_Ptr Body;
-	ElseNode_Ptr Else;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (IfKeyword != nullptr)
-			IfKeyword->print(level);
-		if (Condition != nullptr)
-			Condition->print(level);
-		if (Body != nullptr)
-			Body->print(level);
-		if (Else != nullptr)
-			Else->print(level);
-	}
+	Expression_Ptr Condition = nullptr;
+	Body_Ptr Body = nullptr;
+	ElseNode_Ptr Else = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(IfStatement)
+}; NODE_PTR(IfStatement)
 
 struct ElseIf : ElseNode
 {
-	IfStatement_Ptr If;
-
-	void print(int level) override
-	{
-		ElseNode::print(level);
-		level++;
-		if (If != nullptr)
-			If->print(level);
-	}
+	IfStatement_Ptr If = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(ElseIf)
+}; NODE_PTR(ElseIf)
 
 struct Else : ElseNode
 {
-	Body_Ptr ElseBody;
-
-	void print(int level) override
-	{
-		ElseNode::print(level);
-		level++;
-		if (ElseBody != nullptr)
-			ElseBody->print(level);
-	}
+	Body_Ptr ElseBody = nullptr;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(Else)
+}; NODE_PTR(Else)
 
 struct ParamDef : Node, VariableDeclaration
 {
-	Identifier_Ptr Name;
-	SeperatorToken_Ptr Seperator;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (Seperator != nullptr)
-			Seperator->print(level);
-		if (Type != nullptr)
-			Type->print(level);
-		if (Name != nullptr)
-			Name->print(level);
-	}
-}; TO_PTR(ParamDef)
+	Identifier_Ptr Name = nullptr;
+	bool HasSeperator = false;
+}; NODE_PTR(ParamDef)
 
 struct FunctionParamsDef : Node
 {
-	OpenParan_Ptr ListStartToken;
 	std::vector<ParamDef_Ptr> Parameters;
-	CloseParan_Ptr ListEndToken;
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if(ListStartToken != nullptr)
-			ListStartToken->print(level);
-
-		for (ParamDef_Ptr param : Parameters)
-		{
-			param->print(level);
-		}
-
-		if (ListEndToken != nullptr)
-			ListEndToken->print(level);
-	}
-}; TO_PTR(FunctionParamsDef)
+	bool HasListEnd = false;
+}; NODE_PTR(FunctionParamsDef)
 
 struct Function : Node
 {
-	TypeKeyword_Ptr ReturnType;
-	Identifier_Ptr Name;
-	FunctionParamsDef_Ptr Parameters;
-	BlockBody_Ptr Body;
+	TypeKeyword_Ptr ReturnType = nullptr;
+	Identifier_Ptr Name = nullptr;
+	FunctionParamsDef_Ptr Parameters = nullptr;
+	BlockBody_Ptr Body = nullptr;
 	bool HasReturn = false;
 	bool IsMain = false;
-
-	InstructionOperand_Ptr functionEndAddress = std::make_shared<InstructionOperand>();
-	InstructionOperand_Ptr functionStartAddress = std::make_shared<InstructionOperand>();
-
-	void print(int level) override
-	{
-		Node::print(level);
-		level++;
-		if (ReturnType != NULL)
-			ReturnType->print(level);
-		if (Name != NULL)
-			Name->print(level);
-		if (Parameters != NULL)
-			Parameters->print(level);
-		if (Body != NULL)
-			Body->print(level);
-	}
+	//bytes of the locals below BP, their slots are given by the semantic check
+	int FrameSize = 0;
+	//lines of the nodes of the function are counted from it. IncrementalSource moves it
+	//instead of the lines when lines are added before the function, elsewhere it is 0.
+	int LineBase = 0;
 
 	void resolveNames(Scope_Ptr scope) override;
 	void generateCode(ProgramCode_Ptr code) override;
-}; TO_PTR(Function)
+}; NODE_PTR(Function)
+
+//addresses of the generated code are kept by ProgramCode, so the arena runs no destructors for these nodes
+static_assert(std::is_trivially_destructible<Function>::value && std::is_trivially_destructible<WhileStatement>::value
+	&& std::is_trivially_destructible<IfStatement>::value && std::is_trivially_destructible<CompExpression>::value,
+	"nodes keep no generated code");
+
+template<typename T> struct NodeKindOf;
+#define NODE_KIND_OF(CLASS) template<> struct NodeKindOf<CLASS> { static const NodeKind Kind = Kind_ ## CLASS; };
+SYNTAX_NODES(NODE_KIND_OF)
+#undef NODE_KIND_OF
+
+//nodes are made only here, so each of them knows its kind
+template<typename T> T* create_node(NodeArena& nodes)
+{
+	T* node = nodes.Make<T>();
+	node->Kind = NodeKindOf<T>::Kind;
+	return node;
+}
 
 struct SyntaxTree
 {
+	//all nodes of the tree, they are released together with it
+	NodeArena Nodes;
+	//functions parsed in parallel keep their nodes in arenas of their own
+	std::vector<std::unique_ptr<NodeArena>> PartNodes;
+	size_t NodesCount() const;
 	std::vector<Function_Ptr> functions;
 	std::vector<Function_Ptr> rezervedFunctions;
 	void resolveNames(Scope_Ptr Scope);
 	void generateCode(ProgramCode_Ptr program);
 }; TO_PTR(SyntaxTree)
 
+//lexed sources with this many lexems or more are parsed in parallel, a function at a time
+const size_t ParallelParsingSize = 1 << 15;
+
+//trees of a source are the same only for the same compiler. Cached trees are keyed by it, so any change to
+//how sources are lexed or parsed or to the fields of nodes must bump it, the tables are checked by the cache as well.
+const char* const CompilerVersion = "1.1";
+
 struct Parser
 {
-	SyntaxTree_Ptr build_syntax_tree(std::vector<Lexem_ptr>);
-	void print_tree(SyntaxTree_Ptr);
+	SyntaxTree_Ptr build_syntax_tree(LexemStream&);
+	SyntaxTree_Ptr build_syntax_tree(const LexemStore&);
+	//verbose print also shows the tokens, as the concrete syntax tree did
+	void print_tree(SyntaxTree_Ptr, bool verbose = false);
+
+	//top level declarations can also be parsed one by one
+	void start(LexemStream&, NodeArena&);
+	bool at_end() { return lexems->type(offset) == EndOfFile; }
+	int position() const { return offset; }
+	Function_Ptr build_function();
 
 private:
 	int offset = 0;
-	std::vector<Lexem_ptr> lexems;
+	//set by the first block of the function found unterminated
+	bool blockEndMissing = false;
+	LexemStream* lexems = nullptr;
+	NodeArena* nodes = nullptr;
+
+	template<typename T> T* make_node()
+	{
+		return create_node<T>(*nodes);
+	}
 
 	bool accept(LexemType type);
 	Identifier_Ptr parse_identifier();
@@ -1004,42 +629,91 @@ private:
 	IdentifierExpression_Ptr parse_identifier_expression();
 	ParamDef_Ptr parse_parameter();
 	FunctionParamsDef_Ptr parse_parameters_list();
-	StatementEnd_Ptr parse_statement_end_token();
+	bool parse_statement_end_token();
+	bool at_parameters_list(int index);
+	bool at_function_start();
+	void synchronize(bool inBlock);
+	void skip_statement(bool complete);
 	StringExpression_Ptr parse_string_expression();
 	CharExpression_Ptr parse_char_expression();
 	IntegerExpression_Ptr parse_integer_expression();
 	FloatExpression_Ptr parse_float_expression();
 	TrueExpresion_Ptr parse_true_expression();
 	FalseExpresion_Ptr parse_false_expression();
-	GroupedExpression_Ptr parse_grouped_expression();
 	Expression_Ptr parse_expression();
 	AssignmentNode_Ptr parse_assignment();
 	DeclarationStatement_Ptr parse_declaration();
-	AssignmentStatement_Ptr parse_assignment_statement();
+	AssignmentStatement_Ptr parse_assignment_statement(IdentifierExpression_Ptr name);
 	EmptyStatement_Ptr parse_continue_or_break_statement();
 	ReturnStatement_Ptr parse_return_statement();
 	ScanNode_Ptr parse_scan();
 	ScanStatement_Ptr parse_scan_statement();
 	PrintNode_Ptr parse_print();
 	PrintStatement_Ptr parse_print_statement();
-	Param_Ptr parse_call_parameter();
-	FunctionParams_Ptr parse_call_parameters();
-	FunctionCallExpression_Ptr parse_function_call_expression();
-	FunctionCallStatement_Ptr parse_function_call_statement();
+	FunctionCallExpression_Ptr parse_function_call_expression(IdentifierExpression_Ptr name);
+	FunctionCallStatement_Ptr parse_function_call_statement(IdentifierExpression_Ptr name);
+	Statement_Ptr parse_identifier_statement();
 	Body_Ptr parse_body();
 	WhileStatement_Ptr parse_while_statement();
 	ElseNode_Ptr parse_else_node();
 	IfStatement_Ptr parse_if_statement();
 	Statement_Ptr parse_statement();
 	BlockBody_Ptr parse_block();
-	Function_Ptr build_function();
-	NotExpression_Ptr parse_not_expression();
-	SubExpression_Ptr parse_sub_expression();
-	Expression_Ptr parse_value_expression();
-	Expression_Ptr parse_multiplication_expression();
-	Expression_Ptr parse_add_expression();
-	OpComp_Ptr parse_comparison_operator();
-	Expression_Ptr parse_comparison_expression();
-	Expression_Ptr parse_or_expression();
-	Expression_Ptr parse_and_expression();
+
+	//rules of expressions are split around the expressions nested in them, parse_expression
+	//keeps the rules waiting for a nested expression on a stack instead of the call stack
+	enum ExpressionRuleKind
+	{
+		LeftOperand,
+		RightOperand,
+		GroupRule,
+		UnaryRule,
+		IndexRule,
+		CallParameterRule
+	};
+	struct ExpressionRule
+	{
+		ExpressionRuleKind Kind;
+		//operands bind at least this tight
+		int MinPower = 0;
+		Node* Owner = nullptr;
+		IdentifierExpression_Ptr Name = nullptr;
+		Param_Ptr Parameter = nullptr;
+		bool NegatesRight = false;
+	};
+	std::vector<ExpressionRule> expressionRules;
+
+	bool start_value(Expression_Ptr& value);
+	bool start_call(IdentifierExpression_Ptr name, Expression_Ptr& value);
+	GroupedExpression_Ptr begin_grouped_expression();
+	void end_grouped_expression(GroupedExpression_Ptr group, Expression_Ptr expression);
+	void end_unary_expression(UnaryExpression_Ptr unary, Expression_Ptr expression);
+	IdentifierExpression_Ptr begin_identifier_expression();
+	void end_identifier_expression(IdentifierExpression_Ptr ident, Expression_Ptr accessPosition);
+	FunctionParams_Ptr begin_call_parameters();
+	Param_Ptr begin_call_parameter();
+	Param_Ptr end_call_parameter(Param_Ptr parameter, Expression_Ptr expression);
+	void add_call_parameter(FunctionParams_Ptr parameters, Param_Ptr parameter);
+	void end_call_parameters(FunctionParams_Ptr parameters);
+	FunctionCallExpression_Ptr make_call(IdentifierExpression_Ptr name, FunctionParams_Ptr parameters);
+
+	//binary operators by lexem type, a higher power binds tighter and 0 ends an expression
+	struct BinaryOperator
+	{
+		int Power;
+		BinaryExpression_Ptr (Parser::*Make)();
+		//a - b is parsed as a + (-b)
+		bool NegatesRight;
+	};
+	struct BinaryOperatorTable
+	{
+		BinaryOperator Operators[Error + 1];
+	};
+	static const BinaryOperatorTable BinaryOperators;
+	static BinaryOperatorTable build_binary_operators();
+
+	template<typename T> BinaryExpression_Ptr make_binary()
+	{
+		return make_node<T>();
+	}
 };
\ No newline at end of file
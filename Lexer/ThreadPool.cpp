@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t threadsCount)
+{
+	if (threadsCount == 0)
+		threadsCount = 1;
+	for (size_t i = 0; i < threadsCount; i++)
+		workers.push_back(thread(&ThreadPool::work, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	taskAdded.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+	static ThreadPool pool(thread::hardware_concurrency());
+	return pool;
+}
+
+void ThreadPool::Run(vector<function<void()>>& tasks)
+{
+	unique_lock<mutex> guard(lock);
+	for (auto& task : tasks)
+		queue.push_back(&task);
+	unfinished += tasks.size();
+	taskAdded.notify_all();
+	tasksDone.wait(guard, [this] { return unfinished == 0; });
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		function<void()>* task = nullptr;
+		{
+			unique_lock<mutex> guard(lock);
+			taskAdded.wait(guard, [this] { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+			task = queue.front();
+			queue.pop_front();
+		}
+
+		(*task)();
+
+		unique_lock<mutex> guard(lock);
+		unfinished--;
+		if (unfinished == 0)
+			tasksDone.notify_all();
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "pch.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//fixed set of worker threads, Run blocks until every given task is done
+struct ThreadPool
+{
+	ThreadPool(size_t threadsCount);
+	~ThreadPool();
+
+	void Run(std::vector<std::function<void()>>& tasks);
+	size_t Size() const { return workers.size(); }
+
+	static ThreadPool& Shared();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>*> queue;
+	std::mutex lock;
+	std::condition_variable taskAdded;
+	std::condition_variable tasksDone;
+	size_t unfinished = 0;
+	bool stopping = false;
+
+	void work();
+};